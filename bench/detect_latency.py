@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+"""detect_latency.py - time from load onset to sys_health_monitor alert.
+
+For every trial the harness waits until the target metric is back under its
+threshold, writes an onset marker to /dev/kmsg, takes a CLOCK_MONOTONIC
+timestamp, starts a controlled load and then watches each alert channel
+until the matching alert shows up:
+
+  kmsg  - the "[Group6] Alert: ..." record in /dev/kmsg.  Emit latency is
+          the alert record's timestamp minus the marker record's, both on
+          the printk clock; observe latency is the moment we read the
+          alert, on CLOCK_MONOTONIC.
+  proc  - /proc/sys_health polled every --proc-poll-ms until the metric
+          crosses the threshold that was configured for the run.
+
+Trials are repeated for every sampling configuration given with --config
+(module parameters passed to insmod, e.g. "poll_ms=1000").  The module is
+reloaded between configurations, with alert_burst=0 unless the
+configuration sets it: the default rate limit (12 alerts per metric per
+minute) would otherwise swallow the kmsg alerts of later trials and report
+them as timeouts.  Per‑trial rows go to --csv; a summary of
+min/p50/p90/p99/max per (config, metric, channel) is printed at the end.
+
+Must run as root.  Example:
+
+  sudo bench/detect_latency.py --ko ./sys_health_monitor.ko \\
+      --config poll_ms=5000 --config poll_ms=1000 --trials 20 \\
+      --metric cpu --metric io --csv latency.csv
+"""
+
+import argparse
+import csv
+import os
+import re
+import select
+import shlex
+import signal
+import subprocess
+import sys
+import time
+
+TAG = "[Group6] "
+ALERT_RE = {
+    "mem": re.compile(re.escape(TAG) + r"Alert: free memory"),
+    "cpu": re.compile(re.escape(TAG) + r"Alert: 1.min CPU load"),
+    "io":  re.compile(re.escape(TAG) + r"Alert: disk I/O"),
+}
+PROC_FIELD = {
+    "mem": ("Memory_free", lambda v, t: v < t),
+    "cpu": ("CPU_load_1m", lambda v, t: v > t),
+    "io":  ("Disk_io_rate", lambda v, t: v > t),
+}
+THRESH_PARAM = {"mem": "mem_threshold", "cpu": "cpu_threshold",
+                "io": "io_threshold"}
+
+DEFAULT_LOAD = {
+    "cpu": "stress-ng --cpu {ncpu} --timeout 600s",
+    "mem": "stress-ng --vm 1 --vm-bytes 90% --vm-keep --timeout 600s",
+    "io":  "fio --name=shm --filename={scratch} --size=1G --rw=write "
+           "--bs=1M --direct=1 --time_based --runtime=600",
+}
+
+
+def monotonic_us():
+    return time.clock_gettime_ns(time.CLOCK_MONOTONIC) // 1000
+
+
+def read_param(name):
+    with open(f"/sys/module/sys_health_monitor/parameters/{name}") as f:
+        return int(f.read().strip())
+
+
+def read_proc():
+    vals = {}
+    with open("/proc/sys_health") as f:
+        for line in f:
+            key, _, rest = line.partition(":")
+            fields = rest.split()
+            if fields and fields[0].lstrip("-").isdigit():
+                vals[key.strip()] = int(fields[0])
+    return vals
+
+
+def proc_breached(metric, threshold):
+    field, cmp = PROC_FIELD[metric]
+    v = read_proc().get(field)
+    return v is not None and cmp(v, threshold)
+
+
+class Kmsg:
+    """Non‑blocking /dev/kmsg reader positioned at the end of the log."""
+
+    def __init__(self):
+        self.fd = os.open("/dev/kmsg", os.O_RDONLY | os.O_NONBLOCK)
+        os.lseek(self.fd, 0, os.SEEK_END)
+
+    def records(self, timeout):
+        r, _, _ = select.select([self.fd], [], [], timeout)
+        if not r:
+            return
+        while True:
+            try:
+                raw = os.read(self.fd, 8192)
+            except BlockingIOError:
+                return
+            except OSError:          # EPIPE: ring overwrote our position
+                continue
+            hdr, _, msg = raw.decode(errors="replace").partition(";")
+            parts = hdr.split(",")
+            yield int(parts[2]), msg.split("\n", 1)[0]
+
+    def mark(self, text):
+        """Log `text` so its record carries a printk‑clock timestamp."""
+        fd = os.open("/dev/kmsg", os.O_WRONLY)
+        try:
+            os.write(fd, f"{text}\n".encode())
+        finally:
+            os.close(fd)
+
+    def close(self):
+        os.close(self.fd)
+
+
+def load_module(ko, params):
+    args = shlex.split(params)
+    if not any(a.startswith("alert_burst=") for a in args):
+        args.append("alert_burst=0")    # measure alerts, not the rate limit
+    subprocess.run(["rmmod", "sys_health_monitor"],
+                   stderr=subprocess.DEVNULL, check=False)
+    subprocess.run(["insmod", ko] + args, check=True)
+
+
+def wait_clear(metric, threshold, settle, limit):
+    """Block until the metric has been under threshold for `settle` s."""
+    deadline = time.monotonic() + limit
+    clear_since = None
+    while time.monotonic() < deadline:
+        if proc_breached(metric, threshold):
+            clear_since = None
+        elif clear_since is None:
+            clear_since = time.monotonic()
+        elif time.monotonic() - clear_since >= settle:
+            return True
+        time.sleep(0.5)
+    return False
+
+
+def run_trial(metric, cmd, threshold, args):
+    # /dev/kmsg timestamps come from local_clock(), not CLOCK_MONOTONIC, so
+    # emit latency is measured from a marker record logged at onset.
+    kmsg = Kmsg()
+    seen = {}
+    marker = f"sys_health_bench: onset {os.getpid()}.{time.monotonic_ns()}"
+    marker_ts = None
+    kmsg.mark(marker)
+    onset = monotonic_us()
+    load = subprocess.Popen(shlex.split(cmd), stdout=subprocess.DEVNULL,
+                            stderr=subprocess.DEVNULL, start_new_session=True)
+    deadline = time.monotonic() + args.timeout
+    next_proc = 0.0
+    try:
+        while time.monotonic() < deadline and len(seen) < 3:
+            for ts, msg in kmsg.records(args.proc_poll_ms / 1000.0):
+                if marker_ts is None:
+                    if msg.endswith(marker):
+                        marker_ts = ts
+                    continue
+                if "kmsg_emit" not in seen and ALERT_RE[metric].search(msg):
+                    seen["kmsg_emit"] = ts - marker_ts
+                    seen["kmsg_observe"] = monotonic_us() - onset
+            now = time.monotonic()
+            if "proc" not in seen and now >= next_proc:
+                next_proc = now + args.proc_poll_ms / 1000.0
+                if proc_breached(metric, threshold):
+                    seen["proc"] = monotonic_us() - onset
+    finally:
+        os.killpg(load.pid, signal.SIGKILL)
+        load.wait()
+        kmsg.close()
+    return seen
+
+
+def pct(sorted_vals, p):
+    if not sorted_vals:
+        return float("nan")
+    k = (len(sorted_vals) - 1) * p / 100.0
+    lo = int(k)
+    hi = min(lo + 1, len(sorted_vals) - 1)
+    return sorted_vals[lo] + (sorted_vals[hi] - sorted_vals[lo]) * (k - lo)
+
+
+def main():
+    ap = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    ap.add_argument("--ko", default="./sys_health_monitor.ko")
+    ap.add_argument("--config", action="append",
+                    help="insmod parameters for one configuration "
+                         "(repeatable, default: module defaults)")
+    ap.add_argument("--metric", action="append", choices=sorted(ALERT_RE),
+                    help="metric(s) to load (repeatable, default: cpu)")
+    ap.add_argument("--load", action="append", default=[], metavar="M=CMD",
+                    help="override the load command for metric M")
+    ap.add_argument("--trials", type=int, default=10)
+    ap.add_argument("--timeout", type=float, default=180.0,
+                    help="give up on a trial after this many seconds")
+    ap.add_argument("--settle", type=float, default=10.0,
+                    help="seconds below threshold required before onset")
+    ap.add_argument("--cooldown-limit", type=float, default=600.0)
+    ap.add_argument("--proc-poll-ms", type=float, default=50.0)
+    ap.add_argument("--scratch", default="/var/tmp/shm_io.bin")
+    ap.add_argument("--csv", default="detect_latency.csv")
+    args = ap.parse_args()
+
+    if os.geteuid() != 0:
+        sys.exit("must run as root (insmod, /dev/kmsg)")
+
+    configs = args.config or [""]
+    metrics = args.metric or ["cpu"]
+    loads = dict(DEFAULT_LOAD)
+    for spec in args.load:
+        m, _, cmd = spec.partition("=")
+        loads[m] = cmd
+
+    results = {}
+    with open(args.csv, "w", newline="") as f:
+        out = csv.writer(f)
+        out.writerow(["config", "metric", "trial", "channel", "latency_ms"])
+        for cfg in configs:
+            load_module(args.ko, cfg)
+            for metric in metrics:
+                threshold = read_param(THRESH_PARAM[metric])
+                cmd = loads[metric].format(ncpu=os.cpu_count(),
+                                           scratch=args.scratch)
+                for trial in range(args.trials):
+                    if not wait_clear(metric, threshold, args.settle,
+                                      args.cooldown_limit):
+                        print(f"{cfg!r} {metric}: never cleared, skipping",
+                              file=sys.stderr)
+                        break
+                    seen = run_trial(metric, cmd, threshold, args)
+                    for chan, us in sorted(seen.items()):
+                        ms = us / 1000.0
+                        out.writerow([cfg, metric, trial, chan, f"{ms:.3f}"])
+                        results.setdefault((cfg, metric, chan), []).append(ms)
+                    f.flush()
+                    print(f"{cfg!r} {metric} #{trial}: " +
+                          " ".join(f"{c}={v / 1000.0:.0f}ms"
+                                   for c, v in sorted(seen.items())),
+                          file=sys.stderr)
+        if os.path.exists(args.scratch):
+            os.unlink(args.scratch)
+
+    print(f"{'config':<24} {'metric':<5} {'channel':<13} {'n':>4} "
+          f"{'min':>9} {'p50':>9} {'p90':>9} {'p99':>9} {'max':>9}")
+    for (cfg, metric, chan), vals in sorted(results.items()):
+        vals.sort()
+        print(f"{cfg or '(defaults)':<24} {metric:<5} {chan:<13} "
+              f"{len(vals):>4} {vals[0]:>9.0f} {pct(vals, 50):>9.0f} "
+              f"{pct(vals, 90):>9.0f} {pct(vals, 99):>9.0f} "
+              f"{vals[-1]:>9.0f}")
+
+
+if __name__ == "__main__":
+    main()
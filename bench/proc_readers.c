@@ -0,0 +1,355 @@
+/*
+ * proc_readers.c – concurrent reader throughput for /proc/sys_health.
+ *
+ * Spawns N threads, pins them round‑robin across NUMA nodes (and across the
+ * CPUs of each node), and has every thread open/read/close the target file
+ * in a tight loop.  Reports aggregate reads/s, per‑read latency percentiles
+ * and, when the module was loaded with bench_timing=1, how the poll_metrics()
+ * timer lateness changes between an idle baseline and the loaded run.
+ *
+ * -n restricts readers to a list of nodes, which makes cross‑node effects
+ * visible: compare "-n 0" with "-n 1,2,3" (readers away from the node the
+ * module's timer runs on), with the module loaded with snap_replicas=1 and
+ * with snap_replicas=0.
+ *
+ * Build:  make -C bench
+ * Usage:  bench/proc_readers [-t threads] [-d seconds] [-b baseline_s]
+ *                            [-f file] [-n node,node...] [-N]
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TIMING_FILE  "/proc/sys_health_timing"
+#define MAX_NODES    64
+#define MAX_CPUS     4096
+
+/* Log‑linear latency histogram: 32 sub‑buckets per power of two. */
+#define SUB_BITS     5
+#define SUB_COUNT    (1u << SUB_BITS)
+#define HIST_SIZE    (64 * SUB_COUNT)
+
+struct reader {
+    pthread_t   tid;
+    int         cpu;
+    int         node;
+    uint64_t    reads;
+    uint64_t    errors;
+    uint64_t    hist[HIST_SIZE];
+};
+
+static const char *target = "/proc/sys_health";
+static atomic_int stop;
+static atomic_int go;
+
+static int node_cpus[MAX_NODES][MAX_CPUS];
+static int node_ncpu[MAX_NODES];
+static int node_id[MAX_NODES];       /* sysfs node number of each slot */
+static int nr_nodes;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static unsigned int hist_index(uint64_t v)
+{
+    unsigned int msb;
+
+    if (v < SUB_COUNT)
+        return (unsigned int)v;
+    msb = 63 - __builtin_clzll(v);
+    return (msb - SUB_BITS + 1) * SUB_COUNT +
+           (unsigned int)((v >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+}
+
+static uint64_t hist_value(unsigned int idx)
+{
+    unsigned int tier = idx / SUB_COUNT, sub = idx % SUB_COUNT;
+
+    if (!tier)
+        return sub;
+    return (uint64_t)(SUB_COUNT + sub) << (tier - 1);
+}
+
+static uint64_t hist_percentile(const uint64_t *h, uint64_t total, double p)
+{
+    uint64_t want = (uint64_t)(total * p / 100.0), seen = 0;
+    unsigned int i;
+
+    for (i = 0; i < HIST_SIZE; i++) {
+        seen += h[i];
+        if (seen > want)
+            return hist_value(i);
+    }
+    return 0;
+}
+
+/* Parse a sysfs cpulist such as "0-3,8-11" into node_cpus[node]. */
+static void parse_cpulist(int node, const char *list)
+{
+    const char *p = list;
+
+    while (*p) {
+        char *end;
+        long a = strtol(p, &end, 10), b = a;
+
+        if (end == p)
+            break;
+        if (*end == '-')
+            b = strtol(end + 1, &end, 10);
+        for (; a <= b && node_ncpu[node] < MAX_CPUS; a++)
+            node_cpus[node][node_ncpu[node]++] = (int)a;
+        p = (*end == ',') ? end + 1 : end;
+        if (*p == '\n')
+            break;
+    }
+}
+
+/* Is @node listed in the comma‑separated @list (NULL = all nodes)? */
+static int node_selected(const char *list, int node)
+{
+    const char *p = list;
+
+    if (!list)
+        return 1;
+    while (*p) {
+        char *end;
+
+        if (strtol(p, &end, 10) == node && end != p)
+            return 1;
+        if (*end != ',')
+            break;
+        p = end + 1;
+    }
+    return 0;
+}
+
+static void discover_topology(int flat, const char *only)
+{
+    char path[128], buf[8192];
+    int n;
+
+    for (n = 0; !flat && n < MAX_NODES; n++) {
+        FILE *f;
+
+        if (!node_selected(only, n))
+            continue;
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/node/node%d/cpulist", n);
+        f = fopen(path, "r");
+        if (!f)
+            continue;
+        if (fgets(buf, sizeof(buf), f))
+            parse_cpulist(nr_nodes, buf);
+        fclose(f);
+        if (node_ncpu[nr_nodes])
+            node_id[nr_nodes++] = n;
+    }
+    if (!nr_nodes && only && !flat) {
+        fprintf(stderr, "no CPUs on nodes %s\n", only);
+        exit(1);
+    }
+    if (!nr_nodes) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        for (n = 0; n < cpus && n < MAX_CPUS; n++)
+            node_cpus[0][n] = n;
+        node_ncpu[0] = n;
+        nr_nodes = 1;
+    }
+}
+
+static void *reader_main(void *arg)
+{
+    struct reader *r = arg;
+    char buf[4096];
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(r->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    while (!atomic_load_explicit(&go, memory_order_acquire))
+        ;
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        uint64_t t0 = now_ns();
+        int fd = open(target, O_RDONLY);
+        ssize_t n;
+
+        if (fd < 0) {
+            r->errors++;
+            continue;
+        }
+        while ((n = read(fd, buf, sizeof(buf))) > 0)
+            ;
+        close(fd);
+        if (n < 0) {
+            r->errors++;
+            continue;
+        }
+        r->hist[hist_index(now_ns() - t0)]++;
+        r->reads++;
+    }
+    return NULL;
+}
+
+/* Returns the timer_late line (count/min/avg/max ns) or -1. */
+static int read_lateness(uint64_t out[4])
+{
+    char line[256];
+    FILE *f = fopen(TIMING_FILE, "r");
+    int found = -1;
+
+    if (!f)
+        return -1;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long c, mn, av, mx;
+
+        if (sscanf(line, "timer_late %llu %llu %llu %llu",
+                   &c, &mn, &av, &mx) == 4) {
+            out[0] = c; out[1] = mn; out[2] = av; out[3] = mx;
+            found = 0;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+static void reset_lateness(void)
+{
+    int fd = open(TIMING_FILE, O_WRONLY);
+
+    if (fd >= 0) {
+        if (write(fd, "0\n", 2) < 0)
+            perror(TIMING_FILE);
+        close(fd);
+    }
+}
+
+static void report_lateness(const char *label)
+{
+    uint64_t l[4];
+
+    if (read_lateness(l) || !l[0]) {
+        printf("%-9s timer lateness: n/a (load with bench_timing=1)\n",
+               label);
+        return;
+    }
+    printf("%-9s timer lateness: ticks=%llu avg=%.3f ms max=%.3f ms\n",
+           label, (unsigned long long)l[0], l[2] / 1e6, l[3] / 1e6);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-t threads] [-d seconds] [-b baseline_s] "
+            "[-f file] [-n nodes] [-N]\n"
+            "  -n  comma‑separated list of nodes to run readers on\n"
+            "  -N  ignore NUMA topology, pin over all online CPUs\n",
+            prog);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 0, duration = 10, baseline = 0, flat = 0, opt, i;
+    const char *only = NULL;
+    uint64_t *total_hist, reads = 0, errors = 0, t0, t1;
+    uint64_t node_reads[MAX_NODES] = { 0 };
+    struct reader *rd;
+    double secs;
+
+    while ((opt = getopt(argc, argv, "t:d:b:f:n:Nh")) != -1) {
+        switch (opt) {
+        case 't': threads  = atoi(optarg); break;
+        case 'd': duration = atoi(optarg); break;
+        case 'b': baseline = atoi(optarg); break;
+        case 'f': target   = optarg;       break;
+        case 'n': only     = optarg;       break;
+        case 'N': flat     = 1;            break;
+        default:  usage(argv[0]);
+        }
+    }
+
+    discover_topology(flat, only);
+    if (threads <= 0)
+        for (i = 0; i < nr_nodes; i++)
+            threads += node_ncpu[i];
+
+    rd = calloc(threads, sizeof(*rd));
+    total_hist = calloc(HIST_SIZE, sizeof(*total_hist));
+    if (!rd || !total_hist) {
+        perror("calloc");
+        return 1;
+    }
+
+    if (baseline > 0) {
+        reset_lateness();
+        sleep(baseline);
+        report_lateness("baseline");
+    }
+
+    for (i = 0; i < threads; i++) {
+        int node = i % nr_nodes;
+        int slot = (i / nr_nodes) % node_ncpu[node];
+
+        rd[i].node = node;
+        rd[i].cpu  = node_cpus[node][slot];
+        if (pthread_create(&rd[i].tid, NULL, reader_main, &rd[i])) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    reset_lateness();
+    t0 = now_ns();
+    atomic_store_explicit(&go, 1, memory_order_release);
+    sleep(duration);
+    atomic_store(&stop, 1);
+    t1 = now_ns();
+
+    for (i = 0; i < threads; i++) {
+        unsigned int b;
+
+        pthread_join(rd[i].tid, NULL);
+        reads  += rd[i].reads;
+        errors += rd[i].errors;
+        node_reads[rd[i].node] += rd[i].reads;
+        for (b = 0; b < HIST_SIZE; b++)
+            total_hist[b] += rd[i].hist[b];
+    }
+
+    secs = (t1 - t0) / 1e9;
+    printf("file      %s\n", target);
+    printf("threads   %d over %d node(s), %.1f s\n", threads, nr_nodes, secs);
+    printf("reads     %llu (%.0f reads/s), errors %llu\n",
+           (unsigned long long)reads, reads / secs,
+           (unsigned long long)errors);
+    for (i = 0; i < nr_nodes && (nr_nodes > 1 || only); i++)
+        printf("  node%-3d %.0f reads/s\n", node_id[i], node_reads[i] / secs);
+    if (reads)
+        printf("latency   p50=%.1f us p90=%.1f us p99=%.1f us "
+               "p99.9=%.1f us\n",
+               hist_percentile(total_hist, reads, 50) / 1e3,
+               hist_percentile(total_hist, reads, 90) / 1e3,
+               hist_percentile(total_hist, reads, 99) / 1e3,
+               hist_percentile(total_hist, reads, 99.9) / 1e3);
+    report_lateness("loaded");
+
+    free(total_hist);
+    free(rd);
+    return errors ? 2 : 0;
+}
@@ -0,0 +1,239 @@
+#!/bin/sh
+# qemu_scale.sh – measure poll_metrics() cost versus CPU and device count.
+#
+# Boots a throw‑away QEMU guest for every (smp, nodes, devices, io_source,
+# collectors) combination, loads sys_health_monitor with bench_timing=1,
+# lets it sample for a fixed number of ticks and scrapes
+# /proc/sys_health_timing from the serial console.  Results are appended to
+# a CSV file, one row per stage:
+#
+#   smp,nodes,devices,dev_kind,io_source,collectors,stage,count,min_ns,avg_ns,max_ns
+#
+# io_source is the source the module reports it used, which is vm_events (2)
+# whatever was asked for on a kernel without disk stats; a mismatch is also
+# reported on stderr.  A guest that does not print its timing table (failed
+# boot, module load error, timeout) is reported with the tail of its serial
+# log, and the script exits non‑zero once the sweep is done.
+#
+# Guests use the q35 machine; above 255 CPUs they also get an Intel IOMMU
+# with interrupt remapping so the guest can enable x2APIC.
+#
+# Requirements on the host: qemu-system-x86_64, a static busybox, cpio,
+# a guest bzImage built with null_blk and loop (built‑in or as modules) and
+# sys_health_monitor.ko built against that same kernel.
+#
+# Example:
+#   bench/qemu_scale.sh -k bzImage -M /lib/modules/6.8.0 -o scale.csv \
+#       -s "1 2 4 8 16 32 64 128 256" -d "1 16 256 1024 4096"
+#
+# Single‑threaded versus per‑node worker collection on a 4‑node topology:
+#   bench/qemu_scale.sh -k bzImage -n 4 -s "64 256" -c "0x1 0x5"
+set -eu
+
+KERNEL=
+MODDIR=
+KO=$(dirname "$0")/../sys_health_monitor.ko
+BUSYBOX=$(command -v busybox || true)
+OUT=scale.csv
+SMP_LIST="1 2 4 8 16 32 64 128 256"
+DEV_LIST="1 16 256 1024 4096"
+SRC_LIST="1 2"
+NODE_LIST="1"
+COL_LIST="0x1"
+DEV_KIND=nullb
+TICKS=12
+MEM=4096
+QEMU=${QEMU:-qemu-system-x86_64}
+
+usage() {
+    sed -n '2,30p' "$0" | sed 's/^# \{0,1\}//'
+    cat <<USAGE
+
+Options:
+  -k bzImage     guest kernel (required)
+  -M dir         guest /lib/modules/<ver> tree for null_blk.ko/loop.ko
+  -K file        sys_health_monitor.ko (default: $KO)
+  -b busybox     static busybox binary (default: $BUSYBOX)
+  -o file        output CSV (default: $OUT)
+  -s "list"      -smp values (default: $SMP_LIST)
+  -d "list"      device counts (default: $DEV_LIST)
+  -i "list"      io_source values, 1=part_stat 2=vm_events (default: $SRC_LIST)
+  -n "list"      NUMA node counts, CPUs and memory split evenly (default: $NODE_LIST)
+  -c "list"      collectors masks, 0x5 = per‑node workers (default: $COL_LIST)
+  -D kind        nullb or loop (default: $DEV_KIND)
+  -t ticks       samples per run (default: $TICKS)
+  -m MiB         guest memory in MiB (default: $MEM)
+USAGE
+    exit 1
+}
+
+while getopts k:M:K:b:o:s:d:i:n:c:D:t:m:h opt; do
+    case $opt in
+    k) KERNEL=$OPTARG ;;
+    M) MODDIR=$OPTARG ;;
+    K) KO=$OPTARG ;;
+    b) BUSYBOX=$OPTARG ;;
+    o) OUT=$OPTARG ;;
+    s) SMP_LIST=$OPTARG ;;
+    d) DEV_LIST=$OPTARG ;;
+    i) SRC_LIST=$OPTARG ;;
+    n) NODE_LIST=$OPTARG ;;
+    c) COL_LIST=$OPTARG ;;
+    D) DEV_KIND=$OPTARG ;;
+    t) TICKS=$OPTARG ;;
+    m) MEM=$OPTARG ;;
+    *) usage ;;
+    esac
+done
+
+[ -n "$KERNEL" ] && [ -f "$KERNEL" ] || usage
+[ -f "$KO" ] || { echo "missing $KO – run make first" >&2; exit 1; }
+[ -x "$BUSYBOX" ] || { echo "need a static busybox (-b)" >&2; exit 1; }
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT INT TERM
+
+# ─── Build the initramfs once; parameters travel on the kernel cmdline ───
+ROOT=$WORK/root
+mkdir -p "$ROOT/bin" "$ROOT/proc" "$ROOT/sys" "$ROOT/dev" "$ROOT/tmp" \
+         "$ROOT/lib/modules"
+cp "$BUSYBOX" "$ROOT/bin/busybox"
+for app in sh mount insmod modprobe cat sleep echo poweroff losetup \
+           truncate seq grep sed; do
+    ln -sf busybox "$ROOT/bin/$app"
+done
+cp "$KO" "$ROOT/sys_health_monitor.ko"
+if [ -n "$MODDIR" ]; then
+    for m in null_blk loop; do
+        f=$(find "$MODDIR" -name "$m.ko*" | head -n1)
+        [ -n "$f" ] && cp "$f" "$ROOT/lib/modules/"
+    done
+fi
+
+cat > "$ROOT/init" <<'INIT'
+#!/bin/sh
+mount -t proc proc /proc
+mount -t sysfs sys /sys
+mount -t devtmpfs dev /dev
+mount -t tmpfs tmp /tmp
+
+arg() { sed -n "s/.*shb\.$1=\([^ ]*\).*/\1/p" /proc/cmdline; }
+DEVS=$(arg devs); KIND=$(arg kind); SRC=$(arg src); TICKS=$(arg ticks)
+COL=$(arg col)
+
+load() {
+    [ -f /lib/modules/$1.ko ] && insmod /lib/modules/$1.ko "$2"
+}
+
+if [ "$KIND" = loop ]; then
+    load loop "max_loop=0"
+    for i in $(seq 1 "$DEVS"); do
+        truncate -s 1M /tmp/img$i
+        losetup -f /tmp/img$i
+    done
+else
+    load null_blk "nr_devices=$DEVS" ||
+        modprobe null_blk nr_devices="$DEVS"
+fi
+
+insmod /sys_health_monitor.ko collectors="$COL" bench_timing=1 \
+       io_source="$SRC" || poweroff -f
+# First tick only primes the I/O baseline; discard it.
+sleep 6
+echo > /proc/sys_health_timing
+sleep $((TICKS * 5))
+echo "@@SHM_BEGIN"
+cat /proc/sys_health_timing
+echo "@@SHM_END"
+poweroff -f
+INIT
+chmod +x "$ROOT/init"
+(cd "$ROOT" && find . | cpio -o -H newc 2>/dev/null | gzip) > "$WORK/initrd.gz"
+
+[ -s "$OUT" ] ||
+    echo "smp,nodes,devices,dev_kind,io_source,collectors,stage,count,min_ns,avg_ns,max_ns" > "$OUT"
+
+# -numa arguments splitting $1 CPUs and $MEM MiB evenly over $2 nodes.
+numa_args() {
+    cpus=$1 nodes=$2 n=0
+    [ "$nodes" -gt 1 ] || return 0
+    while [ $n -lt "$nodes" ]; do
+        lo=$((n * cpus / nodes)) hi=$(((n + 1) * cpus / nodes - 1))
+        printf ' -object memory-backend-ram,id=m%d,size=%dM' $n $((MEM / nodes))
+        printf ' -numa node,nodeid=%d,cpus=%d-%d,memdev=m%d' $n $lo $hi $n
+        n=$((n + 1))
+    done
+}
+
+# -machine and -device arguments for $1 CPUs: APIC IDs above 254 need
+# x2APIC, which the guest only enables with interrupt remapping.
+machine_args() {
+    if [ "$1" -gt 255 ]; then
+        printf ' -machine q35,kernel-irqchip=split'
+        printf ' -device intel-iommu,intremap=on,eim=on'
+    else
+        printf ' -machine q35'
+    fi
+}
+
+FAILED=0
+
+# ─── Sweep ───────────────────────────────────────────────────────────────
+for smp in $SMP_LIST; do
+ for nodes in $NODE_LIST; do
+  [ "$nodes" -le "$smp" ] || continue
+  for devs in $DEV_LIST; do
+   for src in $SRC_LIST; do
+    for col in $COL_LIST; do
+        echo "smp=$smp nodes=$nodes devices=$devs kind=$DEV_KIND" \
+             "io_source=$src collectors=$col" >&2
+        LOG=$WORK/serial.log
+        ACCEL=
+        [ -w /dev/kvm ] && ACCEL="-enable-kvm -cpu host"
+        # shellcheck disable=SC2046,SC2086
+        timeout $((TICKS * 5 + 300)) "$QEMU" $ACCEL -nographic \
+            $(machine_args "$smp") -smp "$smp" -m "${MEM}M" \
+            $(numa_args "$smp" "$nodes") -no-reboot \
+            -kernel "$KERNEL" -initrd "$WORK/initrd.gz" \
+            -append "console=ttyS0 quiet panic=-1 shb.devs=$devs shb.kind=$DEV_KIND shb.src=$src shb.col=$col shb.ticks=$TICKS" \
+            > "$LOG" 2>&1 || true
+        if ! grep -q '^@@SHM_BEGIN' "$LOG" || ! grep -q '^@@SHM_END' "$LOG"; then
+            echo "FAILED: smp=$smp nodes=$nodes devices=$devs" \
+                 "io_source=$src collectors=$col: no timing table," \
+                 "serial log ends with:" >&2
+            tail -n 20 "$LOG" >&2
+            FAILED=$((FAILED + 1))
+            continue
+        fi
+        # Label rows with the source the module actually used (io_source=
+        # in the timing header): without disk stats it falls back to
+        # vm_events (2).
+        tr -d '\r' < "$LOG" | awk -v pre="$smp,$nodes,$devs,$DEV_KIND" \
+                                  -v col="$col" -v want="$src" '
+            /^@@SHM_BEGIN/ { on = 1; used = want; next }
+            /^@@SHM_END/   { on = 0 }
+            on && /^#/ {
+                for (i = 1; i <= NF; i++)
+                    if ($i ~ /^io_source=/) {
+                        used = substr($i, 11)
+                        if (used != want)
+                            printf "io_source=%s unsupported, module " \
+                                   "used %s\n", want, used > "/dev/stderr"
+                    }
+                next
+            }
+            on && NF == 5 {
+                printf "%s,%s,%s,%s,%s,%s,%s,%s\n", pre, used, col,
+                       $1, $2, $3, $4, $5
+            }' >> "$OUT"
+    done
+   done
+  done
+ done
+done
+
+echo "results written to $OUT" >&2
+if [ "$FAILED" -gt 0 ]; then
+    echo "$FAILED configuration(s) failed, see above" >&2
+    exit 1
+fi
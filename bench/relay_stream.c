@@ -0,0 +1,228 @@
+/*
+ * relay_stream.c – splice() versus read()/write() on the relay sample stream.
+ *
+ * Loads the module's relay channel (debugfs sys_health/samples0, module
+ * loaded with relay_pages=N) into a file or socket the two ways a capture
+ * tool would: read() into a buffer and write() it out, or splice() the
+ * sub‑buffer pages through a pipe.  Each mode first lets a backlog build up
+ * for -w seconds and times draining it (MB/s and CPU per MB, the burst
+ * case), then streams for -d seconds at the sampling rate and reports CPU
+ * use (the steady case).  Both modes consume the channel, so they run one
+ * after the other, each with its own backlog.
+ *
+ * Load the module with e.g. poll_ms=10 relay_pages=1024 (4 MiB, about 7 min
+ * of samples at 10 ms) and mount debugfs.
+ *
+ * Build:  make -C bench
+ * Usage:  bench/relay_stream [-m read|splice|both] [-w backlog_s]
+ *                            [-d seconds] [-f relay_file] [-o output]
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RECORD_SIZE  88              /* sizeof(struct sh_record) */
+#define CHUNK        (1 << 20)
+
+struct result {
+    uint64_t bytes;
+    double   secs;
+    double   cpu;                    /* user + system seconds */
+};
+
+static const char *source = "/sys/kernel/debug/sys_health/samples0";
+static const char *output = "/dev/null";
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpu_s(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static int open_or_die(const char *path, int flags)
+{
+    int fd = open(path, flags, 0644);
+
+    if (fd < 0) {
+        perror(path);
+        exit(1);
+    }
+    return fd;
+}
+
+/* One transfer of up to CHUNK bytes; 0 when the channel is empty. */
+static ssize_t move_read(int in, int out, char *buf)
+{
+    ssize_t n = read(in, buf, CHUNK), done = 0;
+
+    while (n > 0 && done < n) {
+        ssize_t w = write(out, buf + done, n - done);
+
+        if (w < 0)
+            return -1;
+        done += w;
+    }
+    return n;
+}
+
+static ssize_t move_splice(int in, int out, const int pipefd[2])
+{
+    ssize_t n = splice(in, NULL, pipefd[1], NULL, CHUNK,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK), done = 0;
+
+    if (n < 0 && errno == EAGAIN)
+        return 0;
+    while (n > 0 && done < n) {
+        ssize_t w = splice(pipefd[0], NULL, out, NULL, n - done,
+                           SPLICE_F_MOVE);
+
+        if (w < 0)
+            return -1;
+        done += w;
+    }
+    return n;
+}
+
+static ssize_t move(int use_splice, int in, int out, char *buf,
+                    const int pipefd[2])
+{
+    return use_splice ? move_splice(in, out, pipefd)
+                      : move_read(in, out, buf);
+}
+
+/* Drain until the channel is empty (duration <= 0) or for @duration s. */
+static int run(int use_splice, double duration, struct result *res)
+{
+    int in = open_or_die(source, O_RDONLY | O_NONBLOCK);
+    int out = open_or_die(output, O_WRONLY | O_CREAT | O_TRUNC);
+    int pipefd[2];
+    char *buf = malloc(CHUNK);
+    double t0, c0, end;
+
+    if (!buf || pipe(pipefd)) {
+        perror("setup");
+        exit(1);
+    }
+    fcntl(pipefd[1], F_SETPIPE_SZ, CHUNK);
+
+    memset(res, 0, sizeof(*res));
+    t0 = now_s();
+    c0 = cpu_s();
+    end = t0 + duration;
+    for (;;) {
+        ssize_t n = move(use_splice, in, out, buf, pipefd);
+
+        if (n < 0) {
+            fprintf(stderr, "%s: %s\n", use_splice ? "splice" : "read",
+                    strerror(errno));
+            return -1;
+        }
+        res->bytes += n;
+        if (duration <= 0) {
+            if (!n)
+                break;
+        } else if (now_s() >= end) {
+            break;
+        } else if (!n) {
+            struct pollfd p = { .fd = in, .events = POLLIN };
+
+            poll(&p, 1, 100);
+        }
+    }
+    res->secs = now_s() - t0;
+    res->cpu  = cpu_s() - c0;
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+    close(out);
+    close(in);
+    free(buf);
+    return 0;
+}
+
+static void report(const char *mode, const char *phase,
+                   const struct result *r)
+{
+    double mb = r->bytes / 1e6;
+
+    printf("%-6s %-6s %10.2f MB %9llu rec %8.3f s %9.1f MB/s "
+           "cpu %7.3f s (%5.1f%%, %8.1f us/MB)\n",
+           mode, phase, mb, (unsigned long long)(r->bytes / RECORD_SIZE),
+           r->secs, r->secs > 0 ? mb / r->secs : 0.0, r->cpu,
+           r->secs > 0 ? 100.0 * r->cpu / r->secs : 0.0,
+           mb > 0 ? r->cpu * 1e6 / mb : 0.0);
+}
+
+static int bench(int use_splice, int backlog, int duration)
+{
+    const char *mode = use_splice ? "splice" : "read";
+    struct result r;
+
+    if (run(use_splice, 0, &r))     /* start from an empty channel */
+        return -1;
+    if (backlog > 0) {
+        sleep(backlog);
+        if (run(use_splice, 0, &r))
+            return -1;
+        report(mode, "burst", &r);
+    }
+    if (duration > 0) {
+        if (run(use_splice, duration, &r))
+            return -1;
+        report(mode, "steady", &r);
+    }
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-m read|splice|both] [-w backlog_s] [-d seconds] "
+            "[-f relay_file] [-o output]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    int backlog = 30, duration = 10, opt, ret = 0;
+    const char *mode = "both";
+
+    while ((opt = getopt(argc, argv, "m:w:d:f:o:h")) != -1) {
+        switch (opt) {
+        case 'm': mode     = optarg;       break;
+        case 'w': backlog  = atoi(optarg); break;
+        case 'd': duration = atoi(optarg); break;
+        case 'f': source   = optarg;       break;
+        case 'o': output   = optarg;       break;
+        default:  usage(argv[0]);
+        }
+    }
+    if (strcmp(mode, "read") && strcmp(mode, "splice") && strcmp(mode, "both"))
+        usage(argv[0]);
+
+    printf("source %s -> %s\n", source, output);
+    if (strcmp(mode, "splice"))
+        ret |= bench(0, backlog, duration);
+    if (strcmp(mode, "read"))
+        ret |= bench(1, backlog, duration);
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * ring_consumer.c – throughput of the /proc/sys_health_ring mmap ring.
+ *
+ * Live mode (default) maps the ring of a module loaded with mmap_pages=N
+ * and measures, for -d seconds each:
+ *
+ *   window  re‑copying the whole ring with sh_ring_read(), records/s and
+ *           GB/s: the cost of a catch‑up after a long pause, no syscalls;
+ *   read    the same number of records from /proc/sys_health_history with
+ *           lseek(SEEK_END) + read(), for comparison;
+ *   follow  tracking new records as they are published, reporting records
+ *           received, records lost and CPU use of a 1 ms polling loop.
+ *
+ * Simulation mode (-s) needs no module: a writer thread publishes records
+ * into an in‑process ring of -p pages, -r per second or as fast as it can
+ * (-r 0, which keeps the reader permanently overrun), using the same
+ * protocol as ring_write() in the module, and a reader follows it with
+ * sh_ring.h.  Every record carries its sequence number in each value slot,
+ * so the reader can prove that it never returns a torn or out‑of‑order
+ * record, and the lost count shows how overruns are reported.
+ *
+ * Build:  make -C bench
+ * Usage:  bench/ring_consumer [-d seconds] [-f ring_file]
+ *         bench/ring_consumer -s [-p pages] [-r rate] [-d seconds] [-b batch]
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../userspace/sh_ring.h"
+
+#define HISTORY_FILE "/proc/sys_health_history"
+
+static const char *ring_path = SH_RING_PATH;
+static atomic_int stop;
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpu_s(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_THREAD, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static void report(const char *what, uint64_t recs, double secs)
+{
+    printf("%-7s %12llu rec %8.3f s %14.0f rec/s %8.3f GB/s\n", what,
+           (unsigned long long)recs, secs, recs / secs,
+           recs * sizeof(struct sh_record) / secs / 1e9);
+}
+
+/* ─── Live ring ─────────────────────────────────────────────────────── */
+
+static void bench_window(struct sh_ring *r, struct sh_record *buf,
+                         int duration)
+{
+    uint64_t recs = 0, lost = 0;
+    double t0 = now_s(), end = t0 + duration;
+
+    while (now_s() < end) {
+        r->cursor = 0;              /* from the oldest record held */
+        recs += sh_ring_read(r, buf, r->slots, &lost);
+    }
+    report("window", recs, now_s() - t0);
+}
+
+static void bench_read(unsigned int nr, struct sh_record *buf, int duration)
+{
+    int fd = open(HISTORY_FILE, O_RDONLY);
+    uint64_t recs = 0;
+    double t0, end;
+
+    if (fd < 0) {
+        perror(HISTORY_FILE);
+        return;
+    }
+    t0 = now_s();
+    end = t0 + duration;
+    while (now_s() < end) {
+        ssize_t n;
+
+        if (lseek(fd, -(off_t)nr, SEEK_END) < 0 &&
+            lseek(fd, 0, SEEK_SET) < 0)
+            break;
+        while ((n = read(fd, buf, nr * sizeof(*buf))) > 0)
+            recs += n / sizeof(*buf);
+        if (n < 0)
+            break;
+    }
+    report("read", recs, now_s() - t0);
+    close(fd);
+}
+
+static void bench_follow(struct sh_ring *r, struct sh_record *buf,
+                         int duration)
+{
+    uint64_t recs = 0, lost = 0;
+    double t0 = now_s(), c0 = cpu_s(), end = t0 + duration, secs;
+
+    sh_ring_seek_end(r);
+    while (now_s() < end) {
+        int n = sh_ring_read(r, buf, r->slots, &lost);
+
+        recs += n;
+        if (!n)
+            usleep(1000);
+    }
+    secs = now_s() - t0;
+    printf("follow  %12llu rec %8.3f s %14.1f rec/s lost %llu, "
+           "cpu %.3f s (%.2f%%)\n",
+           (unsigned long long)recs, secs, recs / secs,
+           (unsigned long long)lost, cpu_s() - c0,
+           100.0 * (cpu_s() - c0) / secs);
+}
+
+static int run_live(int duration)
+{
+    struct sh_record *buf;
+    struct sh_ring r;
+    int ret = sh_ring_open(&r, ring_path);
+
+    if (ret) {
+        fprintf(stderr, "%s: %s (load with mmap_pages=N)\n", ring_path,
+                strerror(-ret));
+        return 1;
+    }
+    buf = calloc(r.slots, sizeof(*buf));
+    if (!buf) {
+        perror("calloc");
+        return 1;
+    }
+    printf("ring    %s, %llu slots, head %llu\n", ring_path,
+           (unsigned long long)r.slots,
+           (unsigned long long)sh_ring_head(&r));
+    bench_window(&r, buf, duration);
+    bench_read(r.slots, buf, duration);
+    bench_follow(&r, buf, duration);
+    free(buf);
+    sh_ring_close(&r);
+    return 0;
+}
+
+/* ─── Simulation ────────────────────────────────────────────────────── */
+
+struct sim {
+    struct sh_ring_page *ctl;
+    struct sh_record    *data;
+    uint32_t             slots;
+    double               rate;      /* records/s, 0 = unthrottled */
+};
+
+/* Mirrors ring_write() in sys_health_monitor.c. */
+static void *sim_writer(void *arg)
+{
+    struct sim *s = arg;
+    struct sh_record rec;
+    uint64_t seq = 0;
+    double t0 = now_s();
+    int i;
+
+    memset(&rec, 0, sizeof(rec));
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        if (s->rate > 0 && seq >= (now_s() - t0) * s->rate) {
+            usleep(50);
+            continue;
+        }
+        rec.seq = seq;
+        for (i = 0; i < SH_REC_VALUES; i++)
+            rec.value[i] = (uint32_t)seq;
+        __atomic_store_n(&s->ctl->tail, seq + 1 > s->slots ?
+                         seq + 1 - s->slots : 0, __ATOMIC_RELAXED);
+        atomic_thread_fence(memory_order_release);
+        s->data[seq % s->slots] = rec;
+        __atomic_store_n(&s->ctl->head, seq + 1, __ATOMIC_RELEASE);
+        seq++;
+    }
+    return NULL;
+}
+
+static int run_sim(unsigned int pages, unsigned int batch, double rate,
+                   int duration)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    size_t len = (size_t)(pages + 1) * page;
+    uint64_t recs = 0, lost = 0, expect, bad = 0;
+    struct sh_record *buf = calloc(batch, sizeof(*buf));
+    struct sh_ring r;
+    struct sim s;
+    pthread_t tid;
+    double t0, end, secs;
+    void *base;
+
+    if (!buf || posix_memalign(&base, page, len)) {
+        perror("alloc");
+        return 1;
+    }
+    memset(base, 0, len);
+    s.ctl  = base;
+    s.data = (struct sh_record *)((char *)base + page);
+    s.slots = (uint32_t)((size_t)pages * page / sizeof(struct sh_record));
+    s.rate  = rate;
+    s.ctl->version     = SH_RECORD_VERSION;
+    s.ctl->record_size = sizeof(struct sh_record);
+    s.ctl->nr_records  = s.slots;
+    s.ctl->data_offset = page;
+    s.ctl->data_size   = (uint64_t)s.slots * sizeof(struct sh_record);
+    if (sh_ring_attach(&r, base, len)) {
+        fprintf(stderr, "attach failed\n");
+        return 1;
+    }
+
+    pthread_create(&tid, NULL, sim_writer, &s);
+    expect = r.cursor;
+    t0 = now_s();
+    end = t0 + duration;
+    while (now_s() < end) {
+        uint64_t before = lost;
+        int n = sh_ring_read(&r, buf, batch, &lost), i, j;
+
+        expect += lost - before;
+        if (!n) {
+            usleep(100);
+            continue;
+        }
+        for (i = 0; i < n; i++, expect++) {
+            if (buf[i].seq != expect)
+                bad++;
+            for (j = 0; j < SH_REC_VALUES; j++)
+                if (buf[i].value[j] != (uint32_t)buf[i].seq)
+                    bad++;
+        }
+        recs += n;
+    }
+    secs = now_s() - t0;
+    atomic_store(&stop, 1);
+    pthread_join(tid, NULL);
+
+    printf("sim     %u pages, %u slots, batch %u, written %llu\n", pages,
+           s.slots, batch, (unsigned long long)__atomic_load_n(
+               &s.ctl->head, __ATOMIC_RELAXED));
+    report("read", recs, secs);
+    printf("lost    %llu, torn or out of order %llu\n",
+           (unsigned long long)lost, (unsigned long long)bad);
+    free(buf);
+    free(base);
+    return bad ? 2 : 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-d seconds] [-f ring_file]\n"
+            "       %s -s [-p pages] [-r rate] [-d seconds] [-b batch]\n",
+            prog, prog);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    int duration = 5, sim = 0, opt;
+    unsigned int pages = 64, batch = 256;
+    double rate = 100000;
+
+    while ((opt = getopt(argc, argv, "d:f:sp:r:b:h")) != -1) {
+        switch (opt) {
+        case 'd': duration  = atoi(optarg); break;
+        case 'f': ring_path = optarg;       break;
+        case 's': sim       = 1;            break;
+        case 'p': pages     = atoi(optarg); break;
+        case 'r': rate      = atof(optarg); break;
+        case 'b': batch     = atoi(optarg); break;
+        default:  usage(argv[0]);
+        }
+    }
+    if (duration <= 0 || !pages || !batch)
+        usage(argv[0]);
+    return sim ? run_sim(pages, batch, rate, duration) : run_live(duration);
+}
@@ -0,0 +1,824 @@
+/*───────────────────────────────────────────────────────────────────────────
+ * sys_health_core.h – kernel‑independent logic of sys_health_monitor.
+ *
+ * Everything in here is pure arithmetic and formatting on plain integers so
+ * it can be built twice: inside the module, and in userspace against the
+ * thin type shim in userspace/kshim.h for unit‑speed iteration, the
+ * microbenchmarks and the fuzz targets.  Nothing in this file may touch
+ * kernel state, take locks or sleep.
+ *───────────────────────────────────────────────────────────────────────────*/
+#ifndef SYS_HEALTH_CORE_H
+#define SYS_HEALTH_CORE_H
+
+#ifdef __KERNEL__
+#  include <linux/types.h>
+#  include <linux/kernel.h>
+#  include <linux/math64.h>
+#  include <linux/time64.h>
+#  include <linux/bitops.h>
+#else
+#  include "kshim.h"
+#endif
+
+#include "sys_health_uapi.h"
+
+/* ─── Metrics ──────────────────────────────────────────────────────────── */
+enum sh_metric {
+    SH_METRIC_MEM_FREE,
+    SH_METRIC_CPU_LOAD,
+    SH_METRIC_IO_RATE,
+    SH_METRIC_TICK_LATE,
+    SH_METRIC_WAKEUP_LAT,
+    SH_METRIC_HIGHORDER,
+    SH_METRIC_KMEM_GROWTH,
+    SH_METRIC_MEM_TTE,
+    SH_METRIC_SWAP_TTE,
+    SH_METRIC_COUNT
+};
+
+struct sh_metric_desc {
+    const char *name;
+    const char *unit;
+    bool        below;      /* alert when value < threshold (else >) */
+};
+
+static const struct sh_metric_desc sh_metrics[SH_METRIC_COUNT] = {
+    [SH_METRIC_MEM_FREE] = { "mem_free", "MiB",       true  },
+    [SH_METRIC_CPU_LOAD] = { "cpu_load", "%",         false },
+    [SH_METRIC_IO_RATE]  = { "io_rate",  "sectors/s", false },
+    [SH_METRIC_TICK_LATE] = { "tick_late", "us",       false },
+    [SH_METRIC_WAKEUP_LAT] = { "wakeup_lat", "us",     false },
+    [SH_METRIC_HIGHORDER] = { "highorder_free", "blocks", true },
+    [SH_METRIC_KMEM_GROWTH] = { "kmem_growth", "KiB/min", false },
+    [SH_METRIC_MEM_TTE]   = { "mem_exhaust",  "min",    true  },
+    [SH_METRIC_SWAP_TTE]  = { "swap_exhaust", "min",    true  },
+};
+
+struct sys_snapshot {
+    u64 ts_ms;
+    u32 free_mem_mib;
+    u32 total_mem_mib;
+    u32 load_pct;        /* % of aggregate core capacity */
+    u32 io_rate_sps;     /* disk sectors / second        */
+    u64 fresh_ms[SH_METRIC_COUNT];  /* when each value was last taken */
+    u64 wall_ms;         /* CLOCK_REALTIME of the sample, ms since epoch */
+    u32 late_us;         /* how late the tick fired against its schedule */
+    u32 wakeup_us;       /* worst per‑CPU p99 wakeup latency, last period */
+    u32 highorder_blocks;   /* free blocks of at least frag_alert_order */
+    u32 kmem_growth;     /* steadiest‑growing kernel memory class, KiB/min */
+    u32 mem_tte_min;     /* forecast minutes until MemAvailable hits 0 */
+    u32 swap_tte_min;    /* same for free swap; SH_TTE_NEVER if not falling */
+};
+
+static inline u32 sh_snapshot_value(const struct sys_snapshot *s,
+                                    enum sh_metric id)
+{
+    switch (id) {
+    case SH_METRIC_MEM_FREE: return s->free_mem_mib;
+    case SH_METRIC_CPU_LOAD: return s->load_pct;
+    case SH_METRIC_IO_RATE:  return s->io_rate_sps;
+    case SH_METRIC_TICK_LATE: return s->late_us;
+    case SH_METRIC_WAKEUP_LAT: return s->wakeup_us;
+    case SH_METRIC_HIGHORDER: return s->highorder_blocks;
+    case SH_METRIC_KMEM_GROWTH: return s->kmem_growth;
+    case SH_METRIC_MEM_TTE:  return s->mem_tte_min;
+    case SH_METRIC_SWAP_TTE: return s->swap_tte_min;
+    default:                 return 0;
+    }
+}
+
+/* ─── Rate math ────────────────────────────────────────────────────────── */
+/* Pages → MiB for any page size (the old ">> 10" assumed 4 KiB pages). */
+static inline u32 sh_pages_to_mib(u64 pages, unsigned int page_shift)
+{
+    if (page_shift >= 20)
+        return (u32)min_t(u64, pages << (page_shift - 20), U32_MAX);
+    return (u32)min_t(u64, pages >> (20 - page_shift), U32_MAX);
+}
+
+/* avenrun‑style fixed point load → % of the capacity of @cores CPUs. */
+static inline u32 sh_load_percent(unsigned long avg_fp, unsigned int fshift,
+                                  unsigned int cores)
+{
+    u64 load_x100 = ((u64)avg_fp * 100ULL) >> fshift;
+
+    return (u32)div_u64(load_x100, max_t(unsigned int, cores, 1));
+}
+
+/* Events per second for @delta events observed over @elapsed_ns. */
+static inline u32 sh_rate_per_sec(u64 delta, u64 elapsed_ns)
+{
+    u64 elapsed_ms = div_u64(elapsed_ns, NSEC_PER_MSEC);
+    u64 rate;
+
+    if (!elapsed_ms)
+        return 0;
+    /* delta * 1000 overflows only past ~1.8e16 events; clamp instead. */
+    if (delta > U64_MAX / MSEC_PER_SEC)
+        return U32_MAX;
+    rate = div64_u64(delta * MSEC_PER_SEC, elapsed_ms);
+    return (u32)min_t(u64, rate, U32_MAX);
+}
+
+/* ─── Fragmentation ──────────────────────────────────────────────────────
+ * @nr_free[i] is the number of free buddy blocks of order i, as in
+ * /proc/buddyinfo, for @orders orders.
+ */
+/* Unusable free space index: permille of free pages sitting in blocks too
+ * small for an order‑@order allocation.  0 = all usable, 1000 = none (or
+ * nothing free at all).
+ */
+static inline u32 sh_unusable_index(const unsigned long *nr_free,
+                                    unsigned int orders, unsigned int order)
+{
+    u64 total = 0, usable = 0;
+    unsigned int i;
+
+    for (i = 0; i < orders; i++) {
+        u64 pages = (u64)nr_free[i] << i;
+
+        total += pages;
+        if (i >= order)
+            usable += pages;
+    }
+    if (!total)
+        return 1000;
+    return (u32)div64_u64((total - usable) * 1000, total);
+}
+
+/* How many order‑@order allocations the free lists could satisfy. */
+static inline u64 sh_highorder_blocks(const unsigned long *nr_free,
+                                      unsigned int orders, unsigned int order)
+{
+    u64 blocks = 0;
+    unsigned int i;
+
+    for (i = order; i < orders; i++)
+        blocks += (u64)nr_free[i] << (i - order);
+    return blocks;
+}
+
+/* ─── Trend fitting ──────────────────────────────────────────────────────
+ * Least‑squares slope over the @n newest values of a ring of @len samples
+ * (next write at @head), taken at equal steps.  With centred abscissae
+ * c_i = 2i − (n − 1) the slope is 6·Σ c_i·y_i / (n·(n² − 1)).  Values are
+ * taken relative to the oldest one so the sums stay small; with n ≤
+ * SH_TREND_MAX and steps below 2^32 units the ×1000 scaling cannot
+ * overflow.  @falls counts steps that went down, for monotonicity tests.
+ */
+#define SH_TREND_MAX  256
+
+struct sh_trend {
+    s64 slope_milli;        /* units per sample × 1000 */
+    unsigned int falls;     /* steps where the value decreased */
+};
+
+static inline u64 sh_ring_at(const u64 *ring, unsigned int len,
+                             unsigned int head, unsigned int n, unsigned int i)
+{
+    return ring[(head + len - n + i) % len];
+}
+
+static inline void sh_trend_fit(const u64 *ring, unsigned int len,
+                                unsigned int head, unsigned int n,
+                                struct sh_trend *t)
+{
+    u64 base, prev;
+    s64 sum = 0;
+    unsigned int i;
+
+    t->slope_milli = 0;
+    t->falls = 0;
+    n = min_t(unsigned int, n, min_t(unsigned int, len, SH_TREND_MAX));
+    if (n < 2)
+        return;
+    base = prev = sh_ring_at(ring, len, head, n, 0);
+    for (i = 0; i < n; i++) {
+        u64 y = sh_ring_at(ring, len, head, n, i);
+        s64 d = (s64)(y - base);
+
+        d = clamp_t(s64, d, -(s64)U32_MAX, (s64)U32_MAX);
+        sum += (2 * (s64)i - (s64)(n - 1)) * d;
+        if (y < prev)
+            t->falls++;
+        prev = y;
+    }
+    t->slope_milli = div64_s64(sum * 6000, (s64)n * ((s64)n * n - 1));
+}
+
+/* Time to exhaustion: minutes until @level reaches 0 if it keeps falling at
+ * @slope_milli (units per sample × 1000, as from sh_trend_fit()) with one
+ * sample every @period_ms.  SH_TTE_NEVER when it is not falling.
+ */
+#define SH_TTE_NEVER  U32_MAX
+
+static inline u32 sh_tte_minutes(u64 level, s64 slope_milli, u32 period_ms)
+{
+    u64 secs;
+
+    if (slope_milli >= 0)
+        return SH_TTE_NEVER;
+    level = min_t(u64, level, 1ULL << 40);
+    period_ms = min_t(u32, period_ms, 1U << 22);    /* product < 2^62 */
+    secs = div64_u64(level * period_ms, (u64)-slope_milli);
+    return (u32)min_t(u64, div_u64(secs, 60), SH_TTE_NEVER - 1);
+}
+
+/* ─── Wall‑clock alignment ────────────────────────────────────────────── */
+/* First multiple of @period_ns strictly after @now_ns (both CLOCK_REALTIME),
+ * so every host with the same period samples at the same instants.
+ */
+static inline u64 sh_align_next(u64 now_ns, u64 period_ns)
+{
+    if (!period_ns)
+        return now_ns;
+    return (div64_u64(now_ns, period_ns) + 1) * period_ns;
+}
+
+/* ─── Latency histograms ──────────────────────────────────────────────────
+ * Log2 buckets: bucket 0 holds 0, bucket i ≥ 1 holds [2^(i‑1), 2^i).  The
+ * last bucket also takes everything larger.  Quantiles report the upper
+ * edge of the bucket they fall in, i.e. they are accurate to a factor of 2,
+ * which is enough to tell a healthy host from a stalled one.
+ */
+#define SH_HIST_BUCKETS  32
+
+struct sh_hist {
+    u64 count;
+    u64 max;
+    u64 bucket[SH_HIST_BUCKETS];
+};
+
+static inline unsigned int sh_hist_index(u64 v)
+{
+    return min_t(unsigned int, fls64(v), SH_HIST_BUCKETS - 1);
+}
+
+/* Largest value bucket @i can hold (U64_MAX for the overflow bucket). */
+static inline u64 sh_hist_upper(unsigned int i)
+{
+    if (i >= SH_HIST_BUCKETS - 1)
+        return U64_MAX;
+    return i ? (1ULL << i) - 1 : 0;
+}
+
+static inline void sh_hist_add(struct sh_hist *h, u64 v)
+{
+    h->bucket[sh_hist_index(v)]++;
+    h->count++;
+    if (v > h->max)
+        h->max = v;
+}
+
+static inline void sh_hist_merge(struct sh_hist *dst, const struct sh_hist *src)
+{
+    unsigned int i;
+
+    for (i = 0; i < SH_HIST_BUCKETS; i++)
+        dst->bucket[i] += src->bucket[i];
+    dst->count += src->count;
+    if (src->max > dst->max)
+        dst->max = src->max;
+}
+
+/* Value at or below which @permille / 1000 of the samples lie; never above
+ * the recorded maximum.  0 for an empty histogram.
+ */
+static inline u64 sh_hist_quantile(const struct sh_hist *h,
+                                   unsigned int permille)
+{
+    u64 want, seen = 0;
+    unsigned int i;
+
+    if (!h->count)
+        return 0;
+    want = div_u64(h->count * min_t(unsigned int, permille, 1000) + 999,
+                   1000);
+    for (i = 0; i < SH_HIST_BUCKETS; i++) {
+        seen += h->bucket[i];
+        if (seen >= want && seen)
+            return min_t(u64, sh_hist_upper(i), h->max);
+    }
+    return h->max;
+}
+
+/* ─── Time‑budgeted iteration ─────────────────────────────────────────
+ * Collectors that walk large sets (devices, tasks, cgroups) keep an
+ * sh_cursor across ticks and stop once the tick's sh_budget is spent; the
+ * next tick skips the items already visited and carries on.  The clock is
+ * read only every SH_BUDGET_STRIDE items, so every slice makes at least
+ * that much progress and overshoots the budget by at most one stride.
+ * Iterators that can only restart from the head pay for the skip too, and
+ * sh_budget_charge() bills it to the tick.
+ */
+#define SH_BUDGET_STRIDE  32
+
+struct sh_budget {
+    u64          deadline_ns;   /* U64_MAX: unlimited */
+    unsigned int n;
+};
+
+struct sh_cursor {
+    u64 pos;                    /* items visited in the current pass */
+    u64 acc;                    /* partial sum of the current pass   */
+};
+
+static inline void sh_budget_start(struct sh_budget *b, u64 now_ns,
+                                   u64 budget_ns)
+{
+    b->deadline_ns = budget_ns ? now_ns + budget_ns : U64_MAX;
+    b->n = 0;
+}
+
+/* Count one item; true when the walk should yield until the next tick. */
+static inline bool sh_budget_spent(struct sh_budget *b, u64 (*clock)(void))
+{
+    if (b->deadline_ns == U64_MAX || ++b->n % SH_BUDGET_STRIDE)
+        return false;
+    return clock() >= b->deadline_ns;
+}
+
+/* Bill @skipped items passed over on the way back to the cursor.  Their
+ * time is on the clock already; this makes the first sh_budget_spent()
+ * after them read it, so a skip that used up the budget leaves room for
+ * one new item instead of a whole stride.  The walk never yields while
+ * skipping, so each slice still advances and every pass completes.
+ */
+static inline void sh_budget_charge(struct sh_budget *b, u64 skipped)
+{
+    if (skipped && b->deadline_ns != U64_MAX)
+        b->n = SH_BUDGET_STRIDE - 1;
+}
+
+/* Completes a pass: returns its sum and rewinds the cursor. */
+static inline u64 sh_cursor_finish(struct sh_cursor *c)
+{
+    u64 total = c->acc;
+
+    c->pos = 0;
+    c->acc = 0;
+    return total;
+}
+
+/* ─── Threshold evaluation ─────────────────────────────────────────────── */
+static inline bool sh_breached(enum sh_metric id, u32 value, int threshold)
+{
+    if (sh_metrics[id].below)
+        return threshold > 0 && (s64)value < threshold;
+    return threshold >= 0 && (s64)value > threshold;
+}
+
+/* Bit i set ⇔ metric i has an enabled threshold (see sh_breached()). */
+static inline u32 sh_alerts_armed(const int *thresholds)
+{
+    u32 mask = 0;
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        if (sh_metrics[i].below ? thresholds[i] > 0 : thresholds[i] >= 0)
+            mask |= 1U << i;
+    return mask;
+}
+
+/* Bit i set ⇔ metric i is over its threshold.  @thresholds is indexed by
+ * enum sh_metric.
+ */
+static inline u32 sh_eval_alerts(const struct sys_snapshot *s,
+                                 const int *thresholds)
+{
+    u32 mask = 0;
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        if (sh_breached(i, sh_snapshot_value(s, i), thresholds[i]))
+            mask |= 1U << i;
+    return mask;
+}
+
+/* Bit i set ⇔ metric i holds a value taken before @since_ms, i.e. one its
+ * collector skipped since then (on‑demand mode, a budgeted walk still in
+ * progress).  fresh_ms of 0 marks a collector that is off and reports 0,
+ * which is current.  Both times are jiffies‑based ms and may wrap at 2^32.
+ */
+static inline u32 sh_stale_mask(const struct sys_snapshot *s, u64 since_ms)
+{
+    u32 mask = 0;
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        if (s->fresh_ms[i] && (s32)((u32)s->fresh_ms[i] - (u32)since_ms) < 0)
+            mask |= 1U << i;
+    return mask;
+}
+
+/* ─── Alert transitions ──────────────────────────────────────────────── */
+enum sh_severity {
+    SH_SEV_INFO,            /* within threshold */
+    SH_SEV_WARNING,         /* past the threshold */
+    SH_SEV_CRITICAL,        /* twice as far out: > 2× limit, < ½ floor */
+    SH_SEV_COUNT
+};
+
+enum sh_alert_state {
+    SH_ALERT_RAISED,        /* info → warning/critical */
+    SH_ALERT_CHANGED,       /* warning ↔ critical      */
+    SH_ALERT_CLEARED,       /* warning/critical → info */
+    SH_ALERT_STATE_COUNT
+};
+
+static const char *const sh_severity_names[SH_SEV_COUNT] = {
+    [SH_SEV_INFO]     = "info",
+    [SH_SEV_WARNING]  = "warning",
+    [SH_SEV_CRITICAL] = "critical",
+};
+
+static const char *const sh_alert_state_names[SH_ALERT_STATE_COUNT] = {
+    [SH_ALERT_RAISED]  = "raised",
+    [SH_ALERT_CHANGED] = "changed",
+    [SH_ALERT_CLEARED] = "cleared",
+};
+
+/* One journal record; @severity is the level after the transition. */
+struct sh_alert_event {
+    u64 seq;
+    u64 ts_ms;
+    u32 value;
+    s32 threshold;
+    u8  metric;             /* enum sh_metric      */
+    u8  severity;           /* enum sh_severity    */
+    u8  state;              /* enum sh_alert_state */
+};
+
+static inline enum sh_severity sh_alert_severity(enum sh_metric id, u32 value,
+                                                 int threshold)
+{
+    if (!sh_breached(id, value, threshold))
+        return SH_SEV_INFO;
+    if (sh_metrics[id].below)
+        return (s64)value * 2 < threshold ? SH_SEV_CRITICAL : SH_SEV_WARNING;
+    return (s64)value > 2 * (s64)threshold ? SH_SEV_CRITICAL : SH_SEV_WARNING;
+}
+
+/* Only meaningful for @prev != @next. */
+static inline enum sh_alert_state sh_alert_transition(enum sh_severity prev,
+                                                      enum sh_severity next)
+{
+    if (next == SH_SEV_INFO)
+        return SH_ALERT_CLEARED;
+    return prev == SH_SEV_INFO ? SH_ALERT_RAISED : SH_ALERT_CHANGED;
+}
+
+/* ─── History records ──────────────────────────────────────────────────
+ * One struct sh_record (sys_health_uapi.h) per tick: the unit of the sample
+ * history, of its binary read interface and of the crash dump.
+ */
+_Static_assert(SH_METRIC_COUNT <= SH_REC_VALUES, "sh_record.value is full");
+
+static inline void sh_record_fill(struct sh_record *r, u64 seq,
+                                  const struct sys_snapshot *s,
+                                  const u8 *levels)
+{
+    unsigned int i;
+
+    memset(r, 0, sizeof(*r));
+    r->seq     = seq;
+    r->wall_ms = s->wall_ms;
+    for (i = 0; i < SH_METRIC_COUNT; i++) {
+        r->value[i] = sh_snapshot_value(s, i);
+        r->severity |= (u32)(levels[i] & 3) << (2 * i);
+    }
+}
+
+static inline void sh_record_lost(struct sh_record *r, u64 first, u64 count)
+{
+    memset(r, 0, sizeof(*r));
+    r->seq      = first;
+    r->flags    = SH_REC_LOST;
+    r->value[0] = (u32)count;
+    r->value[1] = (u32)(count >> 32);
+}
+
+static inline enum sh_severity sh_record_severity(const struct sh_record *r,
+                                                  unsigned int metric)
+{
+    return (r->severity >> (2 * metric)) & 3;
+}
+
+/* ─── History queries ─────────────────────────────────────────────────
+ * A query is one line of key=value words, e.g.
+ *
+ *     metric=io_rate last=3600 agg=max bucket=60
+ *
+ *   metric=<name>   required, as in sh_metrics[]
+ *   agg=<kind>      min, max, avg, count or a percentile p50, p99, p99.9
+ *                   (default avg)
+ *   last=<s>        the last s seconds, or
+ *   from=<ms> to=<ms>  wall‑clock ms since the epoch, either may be omitted
+ *   bucket=<s>      one result per s seconds, aligned to multiples of s
+ *                   since from (the epoch when from is omitted); 0 or
+ *                   absent for one result over the whole range
+ *
+ * sh_query_run() evaluates it over two columns of the history ring, the
+ * sample times and one metric's values, touching nothing else.
+ */
+#define SH_QUERY_MAX_LEN  256
+
+enum sh_agg_kind { SH_AGG_MIN, SH_AGG_MAX, SH_AGG_AVG, SH_AGG_COUNT,
+                   SH_AGG_PCT };
+
+struct sh_query {
+    u64 from_ms;                /* 0 = from the oldest sample */
+    u64 to_ms;                  /* U64_MAX = to the newest */
+    u32 last_s;                 /* nonzero: from = now - last_s */
+    u32 bucket_s;
+    u16 permille;               /* SH_AGG_PCT: 0..1000 */
+    u8  metric;
+    u8  agg;
+};
+
+struct sh_bucket {
+    u64 start_ms;               /* bucket start, or first sample's time */
+    u32 count;
+    u32 value;
+};
+
+/* Decimal digits with an optional ".d" (tenths) when @tenths is set. */
+static inline bool sh_query_number(const char *p, size_t n, u64 *out,
+                                   bool tenths)
+{
+    u64 v = 0;
+    size_t i;
+
+    if (!n)
+        return false;
+    for (i = 0; i < n && p[i] != '.'; i++) {
+        if (p[i] < '0' || p[i] > '9' ||
+            v > (U64_MAX - (p[i] - '0')) / 10)
+            return false;
+        v = v * 10 + (p[i] - '0');
+    }
+    if (!i)
+        return false;
+    if (tenths) {
+        if (v > U64_MAX / 10)
+            return false;
+        v *= 10;
+        if (i < n) {
+            if (n - i != 2 || p[i + 1] < '0' || p[i + 1] > '9')
+                return false;
+            v += p[i + 1] - '0';
+        }
+    } else if (i < n) {
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+static inline bool sh_query_word(const char *p, size_t n, const char *w)
+{
+    return strlen(w) == n && !memcmp(p, w, n);
+}
+
+/* Returns 0, or -EINVAL for anything it does not understand. */
+static inline int sh_query_parse(const char *buf, size_t len,
+                                 struct sh_query *q)
+{
+    static const char *const aggs[] = { "min", "max", "avg", "count" };
+    bool have_metric = false, have_from = false;
+    size_t i = 0;
+
+    memset(q, 0, sizeof(*q));
+    q->to_ms = U64_MAX;
+    q->agg   = SH_AGG_AVG;
+
+    while (i < len) {
+        const char *key, *val;
+        size_t klen, vlen;
+        unsigned int j;
+        u64 v;
+
+        if (buf[i] == ' ' || buf[i] == '\t' || buf[i] == '\n') {
+            i++;
+            continue;
+        }
+        key = buf + i;
+        while (i < len && buf[i] != '=' && buf[i] != ' ' &&
+               buf[i] != '\t' && buf[i] != '\n')
+            i++;
+        klen = buf + i - key;
+        if (i == len || buf[i] != '=')
+            return -EINVAL;
+        val = buf + ++i;
+        while (i < len && buf[i] != ' ' && buf[i] != '\t' && buf[i] != '\n')
+            i++;
+        vlen = buf + i - val;
+
+        if (sh_query_word(key, klen, "metric")) {
+            for (j = 0; j < SH_METRIC_COUNT; j++)
+                if (sh_query_word(val, vlen, sh_metrics[j].name))
+                    break;
+            if (j == SH_METRIC_COUNT)
+                return -EINVAL;
+            q->metric = j;
+            have_metric = true;
+        } else if (sh_query_word(key, klen, "agg")) {
+            for (j = 0; j < ARRAY_SIZE(aggs); j++)
+                if (sh_query_word(val, vlen, aggs[j]))
+                    break;
+            if (j < ARRAY_SIZE(aggs)) {
+                q->agg = j;
+            } else if (vlen > 1 && val[0] == 'p' &&
+                       sh_query_number(val + 1, vlen - 1, &v, true) &&
+                       v <= 1000) {
+                q->agg      = SH_AGG_PCT;
+                q->permille = v;
+            } else {
+                return -EINVAL;
+            }
+        } else if (sh_query_word(key, klen, "last")) {
+            if (!sh_query_number(val, vlen, &v, false) || !v ||
+                v > U32_MAX)
+                return -EINVAL;
+            q->last_s = v;
+        } else if (sh_query_word(key, klen, "from")) {
+            if (!sh_query_number(val, vlen, &q->from_ms, false))
+                return -EINVAL;
+            have_from = true;
+        } else if (sh_query_word(key, klen, "to")) {
+            if (!sh_query_number(val, vlen, &q->to_ms, false))
+                return -EINVAL;
+        } else if (sh_query_word(key, klen, "bucket")) {
+            if (!sh_query_number(val, vlen, &v, false) || v > U32_MAX)
+                return -EINVAL;
+            q->bucket_s = v;
+        } else {
+            return -EINVAL;
+        }
+    }
+    if (!have_metric || (q->last_s && have_from) || q->from_ms > q->to_ms)
+        return -EINVAL;
+    return 0;
+}
+
+/* k‑th smallest of v[0..n) (0‑based), reordering v; k < n.  Wirth's
+ * selection: expected O(n), no recursion, no scratch memory.
+ */
+static inline u32 sh_select(u32 *v, u32 n, u32 k)
+{
+    s64 lo = 0, hi = (s64)n - 1;
+
+    while (lo < hi) {
+        u32 pivot = v[lo + ((hi - lo) >> 1)];
+        s64 i = lo, j = hi;
+
+        do {
+            while (v[i] < pivot)
+                i++;
+            while (pivot < v[j])
+                j--;
+            if (i <= j) {
+                u32 t = v[i];
+
+                v[i++] = v[j];
+                v[j--] = t;
+            }
+        } while (i <= j);
+        if (j < k)
+            lo = i;
+        if (k < i)
+            hi = j;
+    }
+    return v[k];
+}
+
+static inline u32 sh_query_value(const struct sh_query *q, u32 *val, u32 n,
+                                 u32 min, u32 max, u64 sum)
+{
+    switch (q->agg) {
+    case SH_AGG_MIN:   return min;
+    case SH_AGG_MAX:   return max;
+    case SH_AGG_COUNT: return n;
+    case SH_AGG_PCT:   return sh_select(val, n, div_u64((u64)(n - 1) *
+                                                         q->permille, 1000));
+    default:           return div_u64(sum, n);
+    }
+}
+
+/*
+ * Fills out[] with up to @max_out buckets for the samples whose time lies
+ * in [from, to] and returns how many.  The @n samples, oldest first, start
+ * at index @first of columns of @len entries and may wrap.  A bucket
+ * closes whenever the next in‑range sample falls outside it, so a
+ * wall‑clock step back starts a new row rather than reopening an old one
+ * and each bucket's samples are contiguous.  Percentiles reorder @val in
+ * place and need the samples unwrapped (first + n <= len).
+ */
+static inline u32 sh_query_run(const struct sh_query *q, u64 from, u64 to,
+                               const u64 *time, u32 *val, u32 len,
+                               u32 first, u32 n, struct sh_bucket *out,
+                               u32 max_out)
+{
+    u64 width = (u64)q->bucket_s * MSEC_PER_SEC, start = 0, sum = 0;
+    u32 i, idx = first, nb = 0, count = 0, head = 0, min = 0, max = 0;
+
+    if (!max_out)
+        return 0;
+    for (i = 0; i <= n; i++, idx = idx + 1 == len ? 0 : idx + 1) {
+        u64 t = i < n ? time[idx] : 0;
+        bool in = i < n && t >= from && t <= to;
+        u32 v;
+
+        if (count && (!in || (width && (t < start || t - start >= width)))) {
+            out[nb].count = count;
+            out[nb].value = sh_query_value(q, val + head, count, min, max,
+                                           sum);
+            if (++nb == max_out)
+                break;
+            count = 0;
+        }
+        if (!in)
+            continue;
+        v = val[idx];
+        if (!count) {
+            head  = idx;
+            min   = max = v;
+            sum   = 0;
+            start = width ? from + div64_u64(t - from, width) * width : t;
+            out[nb].start_ms = start;
+        }
+        min = min_t(u32, min, v);
+        max = max_t(u32, max, v);
+        sum += v;
+        count++;
+    }
+    return nb;
+}
+
+/* ─── Formatting ───────────────────────────────────────────────────────── */
+/* One forecast line: minutes, or "never" when the level is not falling. */
+static inline int sh_format_tte(char *buf, size_t len, const char *label,
+                                u32 minutes)
+{
+    if (minutes == SH_TTE_NEVER)
+        return scnprintf(buf, len, "%snever\n", label);
+    return scnprintf(buf, len, "%s%u min\n", label, minutes);
+}
+
+/* Renders the /proc/sys_health body.  Returns the length written, never
+ * more than @len - 1; output is always NUL‑terminated when @len > 0.
+ */
+static inline int sh_format_snapshot(char *buf, size_t len,
+                                     const struct sys_snapshot *s)
+{
+    int n;
+
+    n = scnprintf(buf, len,
+                  "Timestamp_ms : %llu\n"
+                  "Memory_free  : %u MiB\n"
+                  "Memory_total : %u MiB\n"
+                  "CPU_load_1m  : %u %%\n"
+                  "Disk_io_rate : %u sectors/s\n"
+                  "Fresh_ms     : mem=%llu cpu=%llu io=%llu\n"
+                  "Wall_time_ms : %llu\n"
+                  "Tick_late    : %u us\n"
+                  "Wakeup_p99   : %u us\n"
+                  "High_order   : %u blocks\n"
+                  "Kmem_growth  : %u KiB/min\n",
+                  (unsigned long long)s->ts_ms, s->free_mem_mib,
+                  s->total_mem_mib, s->load_pct, s->io_rate_sps,
+                  (unsigned long long)s->fresh_ms[SH_METRIC_MEM_FREE],
+                  (unsigned long long)s->fresh_ms[SH_METRIC_CPU_LOAD],
+                  (unsigned long long)s->fresh_ms[SH_METRIC_IO_RATE],
+                  (unsigned long long)s->wall_ms, s->late_us,
+                  s->wakeup_us, s->highorder_blocks, s->kmem_growth);
+    n += sh_format_tte(buf + n, len - n, "Mem_exhaust  : ", s->mem_tte_min);
+    n += sh_format_tte(buf + n, len - n, "Swap_exhaust : ", s->swap_tte_min);
+    return n;
+}
+
+/* Longest line sh_format_event() can produce, including the NUL. */
+#define SH_EVENT_MAX_LEN  160
+
+/* Renders one journal record as a single /dev/kmsg‑style line:
+ *   <seq>,<ts_ms>,<severity>,<state>;metric=<name> value=<v> threshold=<t> unit=<u>
+ * Out‑of‑range enum fields print as "?" rather than indexing past a table.
+ */
+static inline int sh_format_event(char *buf, size_t len,
+                                  const struct sh_alert_event *e)
+{
+    return scnprintf(buf, len,
+                     "%llu,%llu,%s,%s;metric=%s value=%u threshold=%d unit=%s\n",
+                     (unsigned long long)e->seq, (unsigned long long)e->ts_ms,
+                     e->severity < SH_SEV_COUNT ?
+                         sh_severity_names[e->severity] : "?",
+                     e->state < SH_ALERT_STATE_COUNT ?
+                         sh_alert_state_names[e->state] : "?",
+                     e->metric < SH_METRIC_COUNT ?
+                         sh_metrics[e->metric].name : "?",
+                     e->value, e->threshold,
+                     e->metric < SH_METRIC_COUNT ?
+                         sh_metrics[e->metric].unit : "?");
+}
+
+#endif /* SYS_HEALTH_CORE_H */
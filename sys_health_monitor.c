@@ -23,6 +23,39 @@
 #include <linux/vmstat.h>
 #include <linux/version.h>
 #include <linux/cpumask.h>
+#include <linux/ktime.h>
+#include <linux/uaccess.h>
+#include <linux/jump_label.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/topology.h>
+#include <linux/nodemask.h>
+#include <linux/slab.h>
+#include <linux/seqlock.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/kfifo.h>
+#include <linux/ratelimit.h>
+#include <linux/kobject.h>
+#include <linux/sysfs.h>
+#include <linux/hrtimer.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
+#include <linux/sched/types.h>
+#include <linux/percpu.h>
+#include <linux/cgroup.h>
+#include <linux/memcontrol.h>
+#include <linux/nsproxy.h>
+#include <linux/swap.h>
+#include <linux/crc32.h>
+#include <linux/relay.h>
+#include <linux/debugfs.h>
+#include <linux/vmalloc.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0)
+#include <linux/panic_notifier.h>
+#endif
+
+#include "sys_health_core.h"
 
 /* ---------- Block‑layer headers present from 5.4 upward ---------------- */
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
@@ -49,180 +82,3412 @@
 #  define HAVE_DISK_STATS 0
 #endif
 
+/* Buddy orders: MAX_ORDER was exclusive before 6.4, inclusive in 6.4–6.7,
+ * and became MAX_PAGE_ORDER/NR_PAGE_ORDERS in 6.8 ------------------------ */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+#  define SH_NR_ORDERS  NR_PAGE_ORDERS
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(6, 4, 0)
+#  define SH_NR_ORDERS  (MAX_ORDER + 1)
+#else
+#  define SH_NR_ORDERS  MAX_ORDER
+#endif
+
 /* ─── Configurable parameters ──────────────────────────────────────────── */
+/* Thresholds take effect at once: a write re‑evaluates the latest sample. */
+static void alerts_reevaluate_param(const int *threshold);
+
+static int threshold_param_set(const char *val, const struct kernel_param *kp)
+{
+    int ret = param_set_int(val, kp);
+
+    if (!ret)
+        alerts_reevaluate_param(kp->arg);
+    return ret;
+}
+
+static const struct kernel_param_ops threshold_param_ops = {
+    .set = threshold_param_set,
+    .get = param_get_int,
+};
+
 static int mem_threshold = 100;     /* MiB free memory floor           */
-module_param(mem_threshold, int, 0644);
+module_param_cb(mem_threshold, &threshold_param_ops, &mem_threshold, 0644);
 MODULE_PARM_DESC(mem_threshold, "Free‑memory threshold in MiB");
 
 static int cpu_threshold = 80;      /* % of total CPU capacity         */
-module_param(cpu_threshold, int, 0644);
+module_param_cb(cpu_threshold, &threshold_param_ops, &cpu_threshold, 0644);
 MODULE_PARM_DESC(cpu_threshold, "CPU threshold as %% of all cores");
 
 static int io_threshold = 5000;     /* sectors per second              */
-module_param(io_threshold, int, 0644);
+module_param_cb(io_threshold, &threshold_param_ops, &io_threshold, 0644);
 MODULE_PARM_DESC(io_threshold, "Disk‑I/O threshold (sectors/s)");
 
+static int late_threshold = -1;     /* us, sampling‑timer lateness     */
+module_param_cb(late_threshold, &threshold_param_ops, &late_threshold, 0644);
+MODULE_PARM_DESC(late_threshold,
+                 "Sampling‑timer lateness threshold in us (-1=off)");
+
+static int wakeup_threshold = -1;   /* us, p99 wakeup latency          */
+module_param_cb(wakeup_threshold, &threshold_param_ops, &wakeup_threshold,
+                0644);
+MODULE_PARM_DESC(wakeup_threshold,
+                 "Per‑CPU p99 wakeup‑latency threshold in us (-1=off)");
+
+static int highorder_threshold = -1;    /* blocks, floor               */
+module_param_cb(highorder_threshold, &threshold_param_ops,
+                &highorder_threshold, 0644);
+MODULE_PARM_DESC(highorder_threshold,
+                 "Alert when fewer free blocks of frag_alert_order remain "
+                 "(-1=off)");
+
+static int leak_threshold = -1;     /* KiB/min, kernel memory growth   */
+module_param_cb(leak_threshold, &threshold_param_ops, &leak_threshold, 0644);
+MODULE_PARM_DESC(leak_threshold,
+                 "Kernel‑memory growth threshold in KiB/min (-1=off)");
+
+static int mem_tte_threshold = -1;  /* min, forecast MemAvailable      */
+module_param_cb(mem_tte_threshold, &threshold_param_ops, &mem_tte_threshold,
+                0644);
+MODULE_PARM_DESC(mem_tte_threshold,
+                 "Alert when memory is forecast to run out within this many "
+                 "minutes (-1=off)");
+
+static int swap_tte_threshold = -1; /* min, forecast free swap         */
+module_param_cb(swap_tte_threshold, &threshold_param_ops,
+                &swap_tte_threshold, 0644);
+MODULE_PARM_DESC(swap_tte_threshold,
+                 "Alert when swap is forecast to run out within this many "
+                 "minutes (-1=off)");
+
+static unsigned int poll_ms = 5000; /* sampling period                 */
+module_param(poll_ms, uint, 0644);
+MODULE_PARM_DESC(poll_ms, "Sampling period in ms (min 10, default 5000)");
+
+static bool align_wallclock;        /* CLOCK_REALTIME‑aligned ticks    */
+module_param(align_wallclock, bool, 0444);
+MODULE_PARM_DESC(align_wallclock,
+                 "Sample on wall‑clock multiples of poll_ms (e.g. :00, :05)");
+
+static bool snap_replicas = true;   /* per‑node copies for readers      */
+module_param(snap_replicas, bool, 0444);
+MODULE_PARM_DESC(snap_replicas,
+                 "Serve /proc readers from a per‑NUMA‑node snapshot copy");
+
+static unsigned int tick_budget_us; /* 0 = walk everything each tick   */
+module_param(tick_budget_us, uint, 0644);
+MODULE_PARM_DESC(tick_budget_us,
+                 "Per‑tick time budget for large‑set collectors in us (0=off)");
+
+/* On‑demand mode: readers collect; the timer keeps only the cheap metrics. */
+static void poll_resume(void);
+
+static bool ondemand;
+static int ondemand_set(const char *val, const struct kernel_param *kp)
+{
+    int ret = param_set_bool(val, kp);
+
+    if (!ret)
+        poll_resume();
+    return ret;
+}
+
+static const struct kernel_param_ops ondemand_param_ops = {
+    .set = ondemand_set,
+    .get = param_get_bool,
+};
+module_param_cb(ondemand, &ondemand_param_ops, &ondemand, 0644);
+MODULE_PARM_DESC(ondemand,
+                 "Collect on read; timer samples only alerting metrics");
+
+static unsigned int read_ttl_ms = 1000;
+module_param(read_ttl_ms, uint, 0644);
+MODULE_PARM_DESC(read_ttl_ms,
+                 "On‑demand mode: max age of a served sample in ms (default 1000)");
+
+static int io_source;               /* 0 auto, 1 part_stat, 2 vm‑events */
+module_param(io_source, int, 0644);
+MODULE_PARM_DESC(io_source,
+                 "Disk‑I/O source: 0=auto, 1=part_stat_read, 2=all_vm_events");
+
+static unsigned int alert_interval_ms = 60000;
+module_param(alert_interval_ms, uint, 0644);
+MODULE_PARM_DESC(alert_interval_ms,
+                 "Alert rate‑limit window per metric in ms (default 60000)");
+
+static unsigned int alert_burst = 12; /* one per default tick */
+module_param(alert_burst, uint, 0644);
+MODULE_PARM_DESC(alert_burst,
+                 "Alerts printed per metric per window, 0=unlimited (default 12)");
+
+static bool alert_uevents = true;
+module_param(alert_uevents, bool, 0644);
+MODULE_PARM_DESC(alert_uevents,
+                 "Send a change uevent on every alert state transition");
+
+static unsigned int uevent_interval_ms = 10000;
+module_param(uevent_interval_ms, uint, 0644);
+MODULE_PARM_DESC(uevent_interval_ms,
+                 "Alert uevent rate‑limit window in ms (default 10000)");
+
+static unsigned int uevent_burst = 10;
+module_param(uevent_burst, uint, 0644);
+MODULE_PARM_DESC(uevent_burst,
+                 "Alert uevents per window, 0=unlimited (default 10)");
+
 /* ─── Module state ─────────────────────────────────────────────────────── */
 #define TAG "[Group6] "
 
-static struct timer_list poll_timer;
+static struct hrtimer poll_timer;    /* fixed schedule, CLOCK_MONOTONIC */
+static struct timer_list align_watchdog;
 static u64 last_io_ticks;           /* tracks cumulative sectors so far */
+static u64 last_io_ns;              /* when last_io_ticks was taken     */
+static int last_io_src;             /* source that produced last_io_ticks */
+static u32 last_io_rate;            /* rate of the last completed pass  */
+static u64 last_io_fresh_ms;        /* when last_io_rate was produced   */
+static struct sh_cursor disk_cursor; /* resumable walk over the disks  */
 static bool io_fallback_logged;
 static struct proc_dir_entry *proc_entry;
+static struct proc_dir_entry *timing_entry;
+static struct proc_dir_entry *alerts_entry;
+static struct proc_dir_entry *lateness_entry;
+static struct proc_dir_entry *wakeup_entry;
+static struct proc_dir_entry *frag_entry;
+static struct proc_dir_entry *kmem_entry;
+static struct proc_dir_entry *history_entry;
+static struct proc_dir_entry *ring_entry;
+static struct proc_dir_entry *query_entry;
 static spinlock_t snap_lock;
 
-struct sys_snapshot {
-    u64 ts_ms;
-    u32 free_mem_mib;
-    u32 total_mem_mib;
-    u32 load_pct;        /* % of aggregate core capacity */
-    u32 io_rate_sps;     /* disk sectors / second        */
-} snapshot;
+#define IO_SRC_AUTO       0
+#define IO_SRC_PART_STAT  1
+#define IO_SRC_VM_EVENTS  2
+
+/* Per‑stage cost of poll_metrics(), filled only while COL_TIMING is on */
+enum timing_stage {
+    TS_MEMORY,
+    TS_LOAD,
+    TS_DISK,
+    TS_TOTAL,
+    TS_LATE,        /* timer firing delay, not a collector */
+    TS_NUMA_WALL,   /* kick → combine of a per‑node round   */
+    TS_COUNT
+};
+
+static const char *const timing_names[TS_COUNT] = {
+    [TS_MEMORY] = "memory",
+    [TS_LOAD]   = "load",
+    [TS_DISK]   = "disk",
+    [TS_TOTAL]  = "total",
+    [TS_LATE]   = "timer_late",
+    [TS_NUMA_WALL] = "numa_wall",
+};
+
+struct stage_timing {
+    u64 count;
+    u64 total_ns;
+    u64 min_ns;
+    u64 max_ns;
+};
+
+static struct stage_timing timing[TS_COUNT];
+static spinlock_t timing_lock;
+
+/* Always on, unlike timing[]: lateness of every tick in us (timing_lock). */
+static struct sh_hist late_hist;
+static u64 late_missed;             /* periods skipped to stay on schedule */
+
+static void timing_reset(void);
+
+/* ─── Optional collectors ──────────────────────────────────────────────
+ * Each optional collector or hook sits behind its own static key, so a
+ * disabled one costs a patched‑out NOP on the hot path rather than a load
+ * and a branch.  "collectors" is the live bit mask; writing it flips the
+ * keys (text patching, process context only).  Keys stay off until
+ * module_init has run: a module's jump entries are not registered while
+ * load‑time parameters are being parsed.
+ */
+enum collector {
+    COL_DISK,               /* per‑disk / vm‑event I/O rate        */
+    COL_TIMING,             /* per‑stage cost, see bench_timing     */
+    COL_NUMA_IO,            /* disk I/O summed by per‑node workers  */
+    COL_WAKEUP,             /* per‑CPU hrtimer wakeup‑latency probe */
+    COL_FRAG,               /* buddy free lists per zone            */
+    COL_KMEM,               /* kernel memory classes and their trend */
+    COL_FORECAST,           /* memory/swap time‑to‑exhaustion       */
+    COL_COUNT
+};
+
+#define COL_ALL           (BIT(COL_COUNT) - 1)
+#define COL_DEFAULT_MASK  BIT(COL_DISK)
+
+static DEFINE_STATIC_KEY_ARRAY_FALSE(collector_keys, COL_COUNT);
+static DEFINE_MUTEX(collector_mutex);
+static unsigned int collector_mask = COL_DEFAULT_MASK;
+static unsigned int collector_applied;     /* bits whose key is enabled */
+static bool collectors_ready;
+
+#define collector_on(c)  static_branch_unlikely(&collector_keys[c])
+
+static int wakeup_start(void);
+static void wakeup_stop(void);
+static void kmem_reset(void);
+static void forecast_reset(void);
+
+/* Side effects of switching a collector, run before its key flips on and
+ * after it flips off.  A collector that fails to start stays off.
+ */
+static int collector_prepare(enum collector c, bool on)
+{
+    if (c == COL_TIMING && on)
+        timing_reset();
+    if (c == COL_KMEM && on)
+        kmem_reset();
+    if (c == COL_FORECAST && on)
+        forecast_reset();
+    if (c == COL_WAKEUP) {
+        if (on)
+            return wakeup_start();
+        wakeup_stop();
+    }
+    return 0;
+}
+
+static void collectors_apply_locked(void)
+{
+    unsigned int changed = collector_mask ^ collector_applied;
+    int c;
+
+    for (c = 0; c < COL_COUNT; c++) {
+        if (!(changed & BIT(c)))
+            continue;
+        if (collector_mask & BIT(c)) {
+            if (collector_prepare(c, true)) {
+                collector_mask &= ~BIT(c);
+                continue;
+            }
+            static_branch_enable(&collector_keys[c]);
+        } else {
+            static_branch_disable(&collector_keys[c]);
+            collector_prepare(c, false);
+        }
+    }
+    collector_applied = collector_mask;
+}
+
+static int collectors_update(unsigned int set, unsigned int clear)
+{
+    mutex_lock(&collector_mutex);
+    collector_mask = (collector_mask & ~clear) | set;
+    if (collectors_ready)
+        collectors_apply_locked();
+    mutex_unlock(&collector_mutex);
+    return 0;
+}
+
+static int collectors_param_set(const char *val, const struct kernel_param *kp)
+{
+    unsigned int mask;
+    int ret = kstrtouint(val, 0, &mask);
+
+    if (ret)
+        return ret;
+    if (mask & ~COL_ALL)
+        return -EINVAL;
+    return collectors_update(mask, COL_ALL);
+}
+
+static int collectors_param_get(char *buf, const struct kernel_param *kp)
+{
+    return scnprintf(buf, PAGE_SIZE, "0x%x\n", READ_ONCE(collector_mask));
+}
+
+static const struct kernel_param_ops collectors_param_ops = {
+    .set = collectors_param_set,
+    .get = collectors_param_get,
+};
+module_param_cb(collectors, &collectors_param_ops, NULL, 0644);
+MODULE_PARM_DESC(collectors,
+                 "Enabled collector mask: bit0=disk I/O, bit1=timing, "
+                 "bit2=per‑node I/O workers, bit3=wakeup latency, "
+                 "bit4=fragmentation, bit5=kernel memory trend, "
+                 "bit6=exhaustion forecast (default 0x1)");
+
+/* bench_timing is kept as a boolean alias for the COL_TIMING bit. */
+static int bench_timing_set(const char *val, const struct kernel_param *kp)
+{
+    bool on;
+    int ret = kstrtobool(val, &on);
+
+    if (ret)
+        return ret;
+    return on ? collectors_update(BIT(COL_TIMING), 0)
+              : collectors_update(0, BIT(COL_TIMING));
+}
+
+static int bench_timing_get(char *buf, const struct kernel_param *kp)
+{
+    return scnprintf(buf, PAGE_SIZE, "%c\n",
+                     READ_ONCE(collector_mask) & BIT(COL_TIMING) ? 'Y' : 'N');
+}
+
+static const struct kernel_param_ops bench_timing_param_ops = {
+    .set = bench_timing_set,
+    .get = bench_timing_get,
+};
+module_param_cb(bench_timing, &bench_timing_param_ops, NULL, 0644);
+MODULE_PARM_DESC(bench_timing,
+                 "Record per‑collector cost in /proc/sys_health_timing");
+
+struct sys_snapshot snapshot;       /* canonical copy, under snap_lock */
+
+/* ─── Per‑node snapshot replicas ──────────────────────────────────────
+ * Every reader of one global snapshot pulls the same cache lines, which
+ * then bounce across sockets each time the writer updates them.  Instead
+ * the writer copies each update into one replica per node with CPUs at
+ * load time (allocated on that node; snap_nodes lists them, so a tick
+ * walks only those) and readers take their own node's copy under a
+ * seqcount, so steady‑state reads never leave the socket and never take a
+ * lock.
+ * Writers are serialised by snap_lock with BHs off, which also keeps them
+ * non‑preemptible as plain seqcount_t requires.
+ */
+struct snap_replica {
+    seqcount_t seq;
+    struct sys_snapshot snap;
+} ____cacheline_aligned_in_smp;
+
+static struct snap_replica *snap_replica[MAX_NUMNODES];
+static nodemask_t snap_nodes;       /* nodes that have a replica */
+
+static void snapshot_publish(const struct sys_snapshot *s)
+{
+    int node;
+
+    spin_lock_bh(&snap_lock);
+    snapshot = *s;
+    for_each_node_mask(node, snap_nodes) {
+        struct snap_replica *r = snap_replica[node];
+
+        write_seqcount_begin(&r->seq);
+        r->snap = *s;
+        write_seqcount_end(&r->seq);
+    }
+    spin_unlock_bh(&snap_lock);
+}
+
+static void snapshot_read(struct sys_snapshot *out)
+{
+    struct snap_replica *r = snap_replica[numa_node_id()];
+    unsigned int seq;
+
+    if (!r) {
+        spin_lock_bh(&snap_lock);
+        *out = snapshot;
+        spin_unlock_bh(&snap_lock);
+        return;
+    }
+
+    do {
+        seq  = read_seqcount_begin(&r->seq);
+        *out = r->snap;
+    } while (read_seqcount_retry(&r->seq, seq));
+}
+
+static int snap_replicas_init(void)
+{
+    int node;
+
+    if (!snap_replicas)
+        return 0;
+    for_each_node_state(node, N_CPU) {
+        struct snap_replica *r = kzalloc_node(sizeof(*r), GFP_KERNEL, node);
+
+        if (!r)
+            return -ENOMEM;
+        seqcount_init(&r->seq);
+        snap_replica[node] = r;
+        node_set(node, snap_nodes);
+    }
+    return 0;
+}
+
+static void snap_replicas_exit(void)
+{
+    int node;
+
+    for_each_node_mask(node, snap_nodes) {
+        kfree(snap_replica[node]);
+        snap_replica[node] = NULL;
+    }
+    nodes_clear(snap_nodes);
+}
 
 /* ─── Helpers ──────────────────────────────────────────────────────────── */
+/* Indexed by enum sh_metric; also backs the sysfs threshold files. */
+static int *const metric_threshold[SH_METRIC_COUNT] = {
+    [SH_METRIC_MEM_FREE] = &mem_threshold,
+    [SH_METRIC_CPU_LOAD] = &cpu_threshold,
+    [SH_METRIC_IO_RATE]  = &io_threshold,
+    [SH_METRIC_TICK_LATE] = &late_threshold,
+    [SH_METRIC_WAKEUP_LAT] = &wakeup_threshold,
+    [SH_METRIC_HIGHORDER] = &highorder_threshold,
+    [SH_METRIC_KMEM_GROWTH] = &leak_threshold,
+    [SH_METRIC_MEM_TTE]   = &mem_tte_threshold,
+    [SH_METRIC_SWAP_TTE]  = &swap_tte_threshold,
+};
+
+static void thresholds_read(int *thresholds)
+{
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        thresholds[i] = READ_ONCE(*metric_threshold[i]);
+    if (!collector_on(COL_FRAG))        /* 0 blocks would read as a breach */
+        thresholds[SH_METRIC_HIGHORDER] = -1;
+    if (!collector_on(COL_KMEM))
+        thresholds[SH_METRIC_KMEM_GROWTH] = -1;
+}
+
+static unsigned long poll_period_jiffies(void)
+{
+    return msecs_to_jiffies(max_t(unsigned int, READ_ONCE(poll_ms), 10));
+}
+
+static u64 poll_period_ns(void)
+{
+    return (u64)max_t(unsigned int, READ_ONCE(poll_ms), 10) * NSEC_PER_MSEC;
+}
+
 static void collect_memory(u32 *free_mib, u32 *total_mib)
 {
     struct sysinfo si;
     si_meminfo(&si);
-    *total_mib = (u32)(si.totalram >> 10);  /* pages → MiB */
-    *free_mib  = (u32)(si.freeram  >> 10);
+    *total_mib = sh_pages_to_mib(si.totalram, PAGE_SHIFT);
+    *free_mib  = sh_pages_to_mib(si.freeram,  PAGE_SHIFT);
 }
 
 static u32 collect_load_percent(void)
 {
-    unsigned long avg_fp = avenrun[1];            /* 1‑minute */
-    u64 load_x100 = (avg_fp * 100ULL) >> FSHIFT;  /* fixed‑pt → % */
-    unsigned int cores = max_t(unsigned int, num_online_cpus(), 1);
-    return div_u64(load_x100, cores);
+    return sh_load_percent(avenrun[0], FSHIFT,      /* 1‑minute */
+                           num_online_cpus());
 }
 
-/* ─── Disk‑I/O collection ─────────────────────────────────────────────── */
-static u32 collect_disk_ios(void)
+/* ─── Benchmark timing ─────────────────────────────────────────────────── */
+static void timing_reset(void)
+{
+    int i;
+
+    spin_lock_bh(&timing_lock);
+    for (i = 0; i < TS_COUNT; i++) {
+        timing[i].count    = 0;
+        timing[i].total_ns = 0;
+        timing[i].min_ns   = U64_MAX;
+        timing[i].max_ns   = 0;
+    }
+    spin_unlock_bh(&timing_lock);
+}
+
+static void timing_add(struct stage_timing *st, u64 ns)
+{
+    st->count++;
+    st->total_ns += ns;
+    if (ns < st->min_ns)
+        st->min_ns = ns;
+    if (ns > st->max_ns)
+        st->max_ns = ns;
+}
+
+/* Per‑tick stages, from the timer (softirq) only: plain spin_lock. */
+static void timing_record(const u64 *ns)
+{
+    int i;
+
+    spin_lock(&timing_lock);
+    for (i = 0; i <= TS_LATE; i++)
+        timing_add(&timing[i], ns[i]);
+    spin_unlock(&timing_lock);
+}
+
+/* Stages measured outside the tick (e.g. by node workers). */
+static void timing_record_one(enum timing_stage stage, u64 ns)
 {
+    spin_lock_bh(&timing_lock);
+    timing_add(&timing[stage], ns);
+    spin_unlock_bh(&timing_lock);
+}
+
+/* ─── Disk‑I/O collection ─────────────────────────────────────────────── */
 #if HAVE_DISK_STATS && HAVE_DISK_ITER
-    /* Preferred path: block‑layer sector counters */
-    u64 io_total = 0;
+/* Preferred path: block‑layer sector counters.  The walk resumes from
+ * disk_cursor; returns false if @b ran out before the last disk, in which
+ * case the partial sum is kept for the next tick.  for_each_disk() can only
+ * start at the head, so the disks already summed are passed over again and
+ * charged to @b: a pointer step each, against a per‑CPU sum for a disk
+ * that is read.  Disks added or removed mid‑pass can be counted twice or
+ * skipped once; the negative‑delta check in collect_disk_ios() absorbs the
+ * resulting glitch.
+ */
+static bool read_disk_sectors(struct sh_budget *b, u64 *io_total)
+{
     struct gendisk *gd;
+    u64 idx = 0;
+    bool done = true;
 
     rcu_read_lock();
     for_each_disk(gd) {
-        io_total += part_stat_read(gd->part0, sectors[STAT_READ])  +
-                     part_stat_read(gd->part0, sectors[STAT_WRITE]);
+        if (idx++ < disk_cursor.pos)
+            continue;
+        if (idx == disk_cursor.pos + 1)
+            sh_budget_charge(b, disk_cursor.pos);
+        disk_cursor.acc += part_stat_read(gd->part0, sectors[STAT_READ])  +
+                           part_stat_read(gd->part0, sectors[STAT_WRITE]);
+        disk_cursor.pos++;
+        if (sh_budget_spent(b, ktime_get_ns)) {
+            done = false;
+            break;
+        }
     }
     rcu_read_unlock();
+
+    if (done)
+        *io_total = sh_cursor_finish(&disk_cursor);
+    return done;
+}
+#endif
+
+/* Fallback path: use PGPGIN/PGPGOUT vm‑event counters which
+ * approximate overall I/O traffic in pages. These counters exist in
+ * all supported kernels even after the NR_PGPG* symbols were dropped.
+ */
+static u64 read_vm_sectors(void)
+{
+    unsigned long events[NR_VM_EVENT_ITEMS];
+    u64 pages_io;
+
+    all_vm_events(events);
+    pages_io = (u64)events[PGPGIN] + (u64)events[PGPGOUT];
+    return pages_io * (PAGE_SIZE >> 9);   /* pages → 512‑byte sectors */
+}
+
+static int io_resolve_source(void)
+{
+    int src = READ_ONCE(io_source);
+
+#if HAVE_DISK_STATS && HAVE_DISK_ITER
+    if (src != IO_SRC_VM_EVENTS)
+        src = IO_SRC_PART_STAT;
 #else
-    /* Fallback path: use PGPGIN/PGPGOUT vm‑event counters which
-     * approximate overall I/O traffic in pages. These counters exist in
-     * all supported kernels even after the NR_PGPG* symbols were dropped.
-     */
     if (!io_fallback_logged) {
         printk(KERN_INFO TAG
                "Disk‑stats interface missing; falling back to PGPGIN/PGPGOUT vm‑events.\n");
         io_fallback_logged = true;
     }
-
-    unsigned long events[NR_VM_EVENT_ITEMS];
-    all_vm_events(events);
-    u64 pages_io = (u64)events[PGPGIN] + (u64)events[PGPGOUT];
-    u64 io_total = pages_io * (PAGE_SIZE >> 9);   /* pages → 512‑byte sectors */
+    src = IO_SRC_VM_EVENTS;
 #endif
+    return src;
+}
+
+/* Switching sources invalidates the baseline; restart the delta. */
+static void io_check_source(int src)
+{
+    if (src != last_io_src) {
+        last_io_src   = src;
+        last_io_ticks = 0;
+        sh_cursor_finish(&disk_cursor);
+    }
+}
 
-    /* Delta against previous sample to obtain rate (per‑5‑second window). */
-    if (!last_io_ticks) {
+/* Feeds one completed total into last_io_rate/last_io_fresh_ms. */
+static void io_update_rate(u64 io_total, u64 now_ns)
+{
+    /* Delta against previous sample over the real elapsed time, so the
+     * rate stays correct whatever poll_ms is and however late the timer ran.
+     */
+    last_io_fresh_ms = jiffies_to_msecs(jiffies);
+    if (!last_io_ticks || io_total < last_io_ticks) {
         last_io_ticks = io_total;
-        return 0;
+        last_io_ns    = now_ns;
+        last_io_rate  = 0;
+        return;
     }
 
-    u64 delta = io_total - last_io_ticks;
+    last_io_rate  = sh_rate_per_sec(io_total - last_io_ticks,
+                                    now_ns - last_io_ns);
     last_io_ticks = io_total;
-    return div_u64(delta, 5);
+    last_io_ns    = now_ns;
 }
 
-/* ─── Timer callback (5 s) ─────────────────────────────────────────────── */
-static void poll_metrics(struct timer_list *t)
+static void collect_disk_ios(struct sh_budget *b)
 {
-    struct sys_snapshot tmp;
+    int src = io_resolve_source();
+    u64 io_total;
 
-    collect_memory(&tmp.free_mem_mib, &tmp.total_mem_mib);
-    tmp.load_pct     = collect_load_percent();
-    tmp.io_rate_sps  = collect_disk_ios();
-    tmp.ts_ms        = jiffies_to_msecs(jiffies);
+    io_check_source(src);
 
-    spin_lock(&snap_lock);
-    snapshot = tmp;
-    spin_unlock(&snap_lock);
+#if HAVE_DISK_STATS && HAVE_DISK_ITER
+    if (src == IO_SRC_PART_STAT) {
+        if (!read_disk_sectors(b, &io_total))
+            return;             /* pass continues next tick */
+    } else
+#endif
+        io_total = read_vm_sectors();
 
-    if (tmp.free_mem_mib < mem_threshold)
-        printk(KERN_WARNING TAG "Alert: free memory %u MiB below %d\n",
-               tmp.free_mem_mib, mem_threshold);
+    io_update_rate(io_total, ktime_get_ns());
+}
 
-    if (tmp.load_pct > cpu_threshold)
-        printk(KERN_WARNING TAG
-               "Alert: 1‑min CPU load %u %% above %d %%\n",
-               tmp.load_pct, cpu_threshold);
+/* ─── Per‑node parallel I/O collection (COL_NUMA_IO) ──────────────────
+ * part_stat_read() and all_vm_events() sum every CPU's counters from the
+ * calling CPU, dragging one remote cache line per CPU (and per disk) across
+ * the interconnect each tick.  In this mode the tick only kicks one worker
+ * per node, pinned to a CPU of that node, which sums its local CPUs; the
+ * last worker to finish combines the partial sums.  The result is consumed
+ * on the following tick, so the rate lags one period, and the tick budget
+ * does not apply.  Nodes that gain their first CPU after load are ignored.
+ * Like the global sums, each worker reads every possible CPU of its node,
+ * online or not, so CPU hotplug never drops counts out of the total; a
+ * node whose CPUs are all offline is summed remotely from any online CPU.
+ */
+struct node_worker {
+    struct work_struct work;
+    int node;
+    int cpu;                /* -1: not part of the current round */
+    int src;
+    u64 sectors;
+    struct cpumask cpus;    /* possible CPUs of the node */
+} ____cacheline_aligned_in_smp;
 
-    if (tmp.io_rate_sps > io_threshold)
-        printk(KERN_WARNING TAG
-               "Alert: disk I/O %u sps above %d\n",
-               tmp.io_rate_sps, io_threshold);
+static struct node_worker *node_workers[MAX_NUMNODES];
+static nodemask_t worker_nodes;     /* nodes that have a worker */
+static atomic_t numa_round;         /* 1 from kick until combine published */
+static atomic_t numa_pending;
+static u64 numa_kick_ns;
+static DEFINE_SPINLOCK(numa_lock);  /* guards the three fields below */
+static u64 numa_sectors;            /* combined total of the last round */
+static u64 numa_done_ns;            /* 0: consumed, nothing new          */
+static int numa_src;
 
-    mod_timer(&poll_timer, jiffies + msecs_to_jiffies(5000));
+static u64 node_disk_sectors(const struct cpumask *mask)
+{
+    u64 io_total = 0;
+#if HAVE_DISK_STATS && HAVE_DISK_ITER
+    struct gendisk *gd;
+    int cpu;
+
+    rcu_read_lock();
+    for_each_disk(gd) {
+        for_each_cpu(cpu, mask) {
+            struct disk_stats *ds = per_cpu_ptr(gd->part0->bd_stats, cpu);
+
+            io_total += ds->sectors[STAT_READ] + ds->sectors[STAT_WRITE];
+        }
+    }
+    rcu_read_unlock();
+#endif
+    return io_total;
 }
 
-/* ─── /proc reader ─────────────────────────────────────────────────────── */
-static int proc_show(struct seq_file *m, void *v)
+static u64 node_vm_sectors(const struct cpumask *mask)
 {
-    struct sys_snapshot s;
-    spin_lock(&snap_lock);
-    s = snapshot;
-    spin_unlock(&snap_lock);
+    u64 pages_io = 0;
+    int cpu;
 
-    seq_printf(m,
-           "Timestamp_ms : %llu\n"
-           "Memory_free  : %u MiB\n"
-           "Memory_total : %u MiB\n"
-           "CPU_load_1m  : %u %%\n"
-           "Disk_io_rate : %u sectors/s\n",
-           s.ts_ms, s.free_mem_mib, s.total_mem_mib,
-           s.load_pct, s.io_rate_sps);
-    return 0;
+    for_each_cpu(cpu, mask) {
+        struct vm_event_state *ev = &per_cpu(vm_event_states, cpu);
+
+        pages_io += ev->event[PGPGIN] + ev->event[PGPGOUT];
+    }
+    return pages_io * (PAGE_SIZE >> 9);
 }
 
-static int proc_open(struct inode *inode, struct file *file)
+static void numa_combine(void)
 {
-    return single_open(file, proc_show, NULL);
+    u64 total = 0, now = ktime_get_ns();
+    int node, src = IO_SRC_VM_EVENTS;
+
+    for_each_node_mask(node, worker_nodes) {
+        struct node_worker *w = node_workers[node];
+
+        if (w->cpu >= 0) {
+            total += w->sectors;
+            src    = w->src;
+        }
+    }
+
+    spin_lock_bh(&numa_lock);
+    numa_sectors = total;
+    numa_done_ns = now;
+    numa_src     = src;
+    spin_unlock_bh(&numa_lock);
+
+    if (collector_on(COL_TIMING))
+        timing_record_one(TS_NUMA_WALL, now - numa_kick_ns);
+    atomic_set_release(&numa_round, 0); /* workers and numa_kick_ns free */
 }
 
-static const struct proc_ops proc_file_ops = {
-    .proc_open    = proc_open,
-    .proc_read    = seq_read,
-    .proc_lseek   = seq_lseek,
-    .proc_release = single_release,
-};
+static void node_worker_fn(struct work_struct *work)
+{
+    struct node_worker *w = container_of(work, struct node_worker, work);
 
-/* ─── Lifecycle ────────────────────────────────────────────────────────── */
-static int __init sys_health_init(void)
+    w->sectors = w->src == IO_SRC_PART_STAT ? node_disk_sectors(&w->cpus)
+                                            : node_vm_sectors(&w->cpus);
+    if (atomic_dec_and_test(&numa_pending))
+        numa_combine();
+}
+
+static void numa_kick(int src)
 {
-    spin_lock_init(&snap_lock);
+    int node;
 
-    printk(KERN_INFO TAG
-           "SCIA 360: Module v1.5 loaded successfully. "
-           "Team Members: Kamden Morgan, Alicia Mansaray, Alex Rodriguez\n");
+    /* Bias by one so no worker can complete the round while we queue. */
+    atomic_set(&numa_pending, 1);
+    numa_kick_ns = ktime_get_ns();
 
-    proc_entry = proc_create("sys_health", 0444, NULL, &proc_file_ops);
-    if (!proc_entry)
-        return -ENOMEM;
+    for_each_node_mask(node, worker_nodes) {
+        struct node_worker *w = node_workers[node];
+        unsigned int cpu;
+
+        cpu = cpumask_any_and(&w->cpus, cpu_online_mask);
+        if (cpu >= nr_cpu_ids)          /* whole node offline */
+            cpu = cpumask_any(cpu_online_mask);
+        w->cpu     = cpu;
+        w->src     = src;
+        w->sectors = 0;
+        atomic_inc(&numa_pending);
+        queue_work_on(cpu, system_highpri_wq, &w->work);
+    }
+
+    if (atomic_dec_and_test(&numa_pending))
+        numa_combine();
+}
+
+static void collect_disk_ios_numa(void)
+{
+    int src = io_resolve_source();
+    u64 done_ns, total;
+    int rsrc;
 
-    timer_setup(&poll_timer, poll_metrics, 0);
-    mod_timer(&poll_timer, jiffies + msecs_to_jiffies(5000));
+    io_check_source(src);
+
+    spin_lock(&numa_lock);
+    done_ns      = numa_done_ns;
+    total        = numa_sectors;
+    rsrc         = numa_src;
+    numa_done_ns = 0;
+    spin_unlock(&numa_lock);
+
+    if (done_ns && rsrc == src)
+        io_update_rate(total, done_ns);
+
+    /* A round still in flight after a whole period: don't pile up.  Only
+     * one caller (tick or on‑demand reader) may open a round, and it stays
+     * open until numa_combine() has read the workers and published, so a
+     * new kick never resets them under a combine.
+     */
+    if (atomic_cmpxchg(&numa_round, 0, 1) == 0)
+        numa_kick(src);
+}
+
+static int numa_workers_init(void)
+{
+    int node, cpu;
+
+    for_each_node_state(node, N_CPU) {
+        struct node_worker *w = kzalloc_node(sizeof(*w), GFP_KERNEL, node);
+
+        if (!w)
+            return -ENOMEM;
+        INIT_WORK(&w->work, node_worker_fn);
+        w->node = node;
+        w->cpu  = -1;
+        for_each_possible_cpu(cpu)
+            if (cpu_to_node(cpu) == node)
+                cpumask_set_cpu(cpu, &w->cpus);
+        node_workers[node] = w;
+        node_set(node, worker_nodes);
+    }
+    return 0;
+}
+
+static void numa_workers_exit(void)
+{
+    int node;
+
+    /* The last worker of a round reads every node's: cancel all first. */
+    for_each_node_mask(node, worker_nodes)
+        cancel_work_sync(&node_workers[node]->work);
+    for_each_node_mask(node, worker_nodes) {
+        kfree(node_workers[node]);
+        node_workers[node] = NULL;
+    }
+    nodes_clear(worker_nodes);
+}
+
+/* ─── Wakeup‑latency probe (COL_WAKEUP) ─────────────────────────────────
+ * cyclictest in the kernel: one SCHED_FIFO kthread per selected CPU sleeps
+ * on an absolute hrtimer every wakeup_interval_us and records how late it
+ * actually ran, in us, into a per‑CPU log2 histogram.  Each tick folds the
+ * window since the last tick into the running total and publishes the
+ * worst per‑CPU p99 of that window as the wakeup_lat metric.  Per‑CPU
+ * p50/p99/max are in /proc/sys_health_wakeup.  wakeup_cpus, wakeup_prio
+ * and wakeup_interval_us apply when the collector is (re)enabled.  A CPU
+ * that goes offline leaves its thread unbound; re‑enable after hotplug.
+ */
+static struct cpumask wakeup_mask;      /* empty: every online CPU */
+static struct cpumask wakeup_running;   /* CPUs with stats, under collector_mutex */
+
+static int wakeup_cpus_set(const char *val, const struct kernel_param *kp)
+{
+    struct cpumask mask;
+    int ret = 0;
+
+    if (sysfs_streq(val, "") || sysfs_streq(val, "all"))
+        cpumask_clear(&mask);
+    else
+        ret = cpulist_parse(val, &mask);
+    if (ret)
+        return ret;
+    mutex_lock(&collector_mutex);
+    cpumask_copy(&wakeup_mask, &mask);
+    mutex_unlock(&collector_mutex);
     return 0;
 }
 
+static int wakeup_cpus_get(char *buf, const struct kernel_param *kp)
+{
+    if (cpumask_empty(&wakeup_mask))
+        return scnprintf(buf, PAGE_SIZE, "all\n");
+    return scnprintf(buf, PAGE_SIZE, "%*pbl\n", cpumask_pr_args(&wakeup_mask));
+}
+
+static const struct kernel_param_ops wakeup_cpus_ops = {
+    .set = wakeup_cpus_set,
+    .get = wakeup_cpus_get,
+};
+module_param_cb(wakeup_cpus, &wakeup_cpus_ops, NULL, 0644);
+MODULE_PARM_DESC(wakeup_cpus, "CPU list for the wakeup probe (default all)");
+
+static unsigned int wakeup_prio = 80;
+module_param(wakeup_prio, uint, 0644);
+MODULE_PARM_DESC(wakeup_prio, "SCHED_FIFO priority of the probe threads "
+                 "(1‑99, default 80)");
+
+static unsigned int wakeup_interval_us = 1000;
+module_param(wakeup_interval_us, uint, 0644);
+MODULE_PARM_DESC(wakeup_interval_us,
+                 "Probe wakeup interval in us (min 50, default 1000)");
+
+struct wakeup_cpu {
+    spinlock_t lock;                    /* thread vs tick */
+    struct sh_hist win;                 /* since the last tick */
+    struct sh_hist total;               /* since enable or reset */
+    u64 last_p99;
+    u64 last_max;
+    struct task_struct *task;
+};
+
+static struct wakeup_cpu __percpu *wakeup_stats;
+
+static int wakeup_thread_fn(void *arg)
+{
+    struct wakeup_cpu *wc = arg;
+    u64 interval = (u64)max_t(unsigned int, READ_ONCE(wakeup_interval_us),
+                              50) * NSEC_PER_USEC;
+    ktime_t next = ktime_get();
+
+    while (!kthread_should_stop()) {
+        s64 lat;
+
+        next = ktime_add_ns(next, interval);
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (kthread_should_stop()) {
+            __set_current_state(TASK_RUNNING);
+            break;
+        }
+        schedule_hrtimeout_range(&next, 0, HRTIMER_MODE_ABS_HARD);
+
+        lat = ktime_to_ns(ktime_sub(ktime_get(), next));
+        if (lat < 0)
+            continue;                   /* woken early: kthread_stop() */
+
+        spin_lock_bh(&wc->lock);
+        sh_hist_add(&wc->win, div_u64(lat, NSEC_PER_USEC));
+        spin_unlock_bh(&wc->lock);
+
+        /* Missed whole periods: restart the schedule, don't catch up. */
+        if (lat > (s64)interval)
+            next = ktime_get();
+    }
+    return 0;
+}
+
+/* Tick side (softirq): fold each window, return the worst p99. */
+static u32 wakeup_collect(void)
+{
+    u64 worst = 0;
+    int cpu;
+
+    for_each_cpu(cpu, &wakeup_running) {
+        struct wakeup_cpu *wc = per_cpu_ptr(wakeup_stats, cpu);
+
+        spin_lock(&wc->lock);
+        wc->last_p99 = sh_hist_quantile(&wc->win, 990);
+        wc->last_max = wc->win.max;
+        sh_hist_merge(&wc->total, &wc->win);
+        memset(&wc->win, 0, sizeof(wc->win));
+        spin_unlock(&wc->lock);
+
+        worst = max(worst, wc->last_p99);
+    }
+    return (u32)min_t(u64, worst, U32_MAX);
+}
+
+/* Under collector_mutex, before COL_WAKEUP's key is enabled. */
+static int wakeup_start(void)
+{
+    struct sched_attr attr = {
+        .size           = sizeof(attr),
+        .sched_policy   = SCHED_FIFO,
+        .sched_priority = clamp_t(unsigned int, READ_ONCE(wakeup_prio),
+                                  1, MAX_RT_PRIO - 1),
+    };
+    struct cpumask cpus;
+    int cpu, ret;
+
+    if (!wakeup_stats) {
+        wakeup_stats = alloc_percpu(struct wakeup_cpu);
+        if (!wakeup_stats)
+            return -ENOMEM;
+        for_each_possible_cpu(cpu)
+            spin_lock_init(&per_cpu_ptr(wakeup_stats, cpu)->lock);
+    }
+
+    if (cpumask_empty(&wakeup_mask))
+        cpumask_copy(&cpus, cpu_online_mask);
+    else
+        cpumask_and(&cpus, &wakeup_mask, cpu_online_mask);
+    if (cpumask_empty(&cpus))
+        return -EINVAL;
+
+    cpumask_clear(&wakeup_running);
+    for_each_cpu(cpu, &cpus) {
+        struct wakeup_cpu *wc = per_cpu_ptr(wakeup_stats, cpu);
+        struct task_struct *t;
+
+        spin_lock_bh(&wc->lock);
+        memset(&wc->win, 0, sizeof(wc->win));
+        memset(&wc->total, 0, sizeof(wc->total));
+        wc->last_p99 = wc->last_max = 0;
+        spin_unlock_bh(&wc->lock);
+
+        t = kthread_create(wakeup_thread_fn, wc, "sys_health_wake/%d", cpu);
+        if (IS_ERR(t)) {
+            ret = PTR_ERR(t);
+            wakeup_stop();
+            return ret;
+        }
+        kthread_bind(t, cpu);
+        ret = sched_setattr_nocheck(t, &attr);
+        if (ret) {
+            kthread_stop(t);
+            wakeup_stop();
+            return ret;
+        }
+        wc->task = t;
+        cpumask_set_cpu(cpu, &wakeup_running);
+        wake_up_process(t);
+    }
+    return 0;
+}
+
+/* Under collector_mutex, after the key is off.  Stats stay readable. */
+static void wakeup_stop(void)
+{
+    int cpu;
+
+    if (!wakeup_stats)
+        return;
+    for_each_cpu(cpu, &wakeup_running) {
+        struct wakeup_cpu *wc = per_cpu_ptr(wakeup_stats, cpu);
+
+        if (wc->task)
+            kthread_stop(wc->task);
+        wc->task = NULL;
+    }
+}
+
+static void wakeup_exit(void)
+{
+    mutex_lock(&collector_mutex);
+    wakeup_stop();
+    mutex_unlock(&collector_mutex);
+    free_percpu(wakeup_stats);
+    wakeup_stats = NULL;
+}
+
+/* ─── Fragmentation (COL_FRAG) ──────────────────────────────────────────
+ * Free memory says nothing about whether an order‑9 allocation (a THP, a
+ * large NIC ring) can succeed.  Each tick sums, over every populated zone,
+ * how many frag_alert_order blocks the buddy free lists could hand out and
+ * publishes that as highorder_free.  /proc/sys_health_frag has the per‑zone
+ * detail: free lists by order, the unusable free space index for each order
+ * in frag_orders, distance to the min/low/high watermarks and the kswapd
+ * counters.  nr_free is read without zone->lock; a tick can be off by a
+ * few blocks, which is fine for a trend.
+ */
+static unsigned int frag_orders = BIT(3) | BIT(9);
+module_param(frag_orders, uint, 0644);
+MODULE_PARM_DESC(frag_orders, "Mask of orders whose unusable index is "
+                 "reported (default 0x208: orders 3 and 9)");
+
+static unsigned int frag_alert_order = 9;
+module_param(frag_alert_order, uint, 0644);
+MODULE_PARM_DESC(frag_alert_order,
+                 "Order counted by highorder_free (default 9)");
+
+static unsigned int frag_order(void)
+{
+    return min_t(unsigned int, READ_ONCE(frag_alert_order), SH_NR_ORDERS - 1);
+}
+
+static void frag_zone_free(struct zone *zone, unsigned long *nr_free)
+{
+    unsigned int o;
+
+    for (o = 0; o < SH_NR_ORDERS; o++)
+        nr_free[o] = READ_ONCE(zone->free_area[o].nr_free);
+}
+
+#define for_each_sh_zone(nid, z, zone)                                  \
+    for_each_online_node(nid)                                           \
+        for ((z) = 0, (zone) = NODE_DATA(nid)->node_zones;             \
+             (z) < MAX_NR_ZONES; (z)++, (zone)++)                      \
+            if (populated_zone(zone))
+
+static u32 frag_collect(void)
+{
+    unsigned long nr_free[SH_NR_ORDERS];
+    unsigned int order = frag_order();
+    struct zone *zone;
+    u64 blocks = 0;
+    int nid, z;
+
+    for_each_sh_zone(nid, z, zone) {
+        frag_zone_free(zone, nr_free);
+        blocks += sh_highorder_blocks(nr_free, SH_NR_ORDERS, order);
+    }
+    return (u32)min_t(u64, blocks, U32_MAX);
+}
+
+/* ─── Kernel memory trend (COL_KMEM) ────────────────────────────────────
+ * A slow kernel leak never shows in free memory until it is too late, but
+ * it does show as one kernel memory class growing steadily.  Each tick
+ * records slab, kernel stack and page‑table usage (KiB, from the global
+ * vmstat counters) into a ring and fits a least‑squares line over the
+ * last leak_window samples.  A class counts as leaking when the window is
+ * full, it fell on at most 1 step in LEAK_DIP_DIV, and its slope is
+ * positive; the steepest such slope is the kmem_growth metric.
+ *
+ * vmalloc and percpu totals (vmalloc_nr_pages(), pcpu_nr_pages()) and the
+ * per‑cache slab list are not exported to modules, so they are not here.
+ */
+enum kmem_class {
+    KMEM_SLAB,
+    KMEM_STACK,
+    KMEM_PAGETABLE,
+    KMEM_COUNT
+};
+
+static const char *const kmem_names[KMEM_COUNT] = {
+    [KMEM_SLAB]      = "slab",
+    [KMEM_STACK]     = "kernel_stack",
+    [KMEM_PAGETABLE] = "pagetables",
+};
+
+#define LEAK_DIP_DIV  10
+
+static unsigned int leak_window = 120;
+module_param(leak_window, uint, 0644);
+MODULE_PARM_DESC(leak_window, "Samples in the kernel‑memory trend window "
+                 "(8‑256, default 120)");
+
+static u64 kmem_ring[KMEM_COUNT][SH_TREND_MAX];
+static unsigned int kmem_head, kmem_filled;
+static int kmem_worst = -1;             /* class behind kmem_growth */
+static DEFINE_SPINLOCK(kmem_lock);      /* tick vs /proc reader */
+
+static unsigned int kmem_window(void)
+{
+    return clamp_t(unsigned int, READ_ONCE(leak_window), 8, SH_TREND_MAX);
+}
+
+static void kmem_read(u64 *kib)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0)
+    kib[KMEM_SLAB]  = (u64)(global_node_page_state_pages(NR_SLAB_RECLAIMABLE_B) +
+                      global_node_page_state_pages(NR_SLAB_UNRECLAIMABLE_B))
+                      << (PAGE_SHIFT - 10);
+    kib[KMEM_STACK] = global_node_page_state(NR_KERNEL_STACK_KB);
+#else
+    kib[KMEM_SLAB]  = (u64)(global_node_page_state(NR_SLAB_RECLAIMABLE) +
+                      global_node_page_state(NR_SLAB_UNRECLAIMABLE))
+                      << (PAGE_SHIFT - 10);
+    kib[KMEM_STACK] = global_zone_page_state(NR_KERNEL_STACK_KB);
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 11, 0)
+    kib[KMEM_PAGETABLE] = (u64)global_node_page_state(NR_PAGETABLE)
+                          << (PAGE_SHIFT - 10);
+#else
+    kib[KMEM_PAGETABLE] = (u64)global_zone_page_state(NR_PAGETABLE)
+                          << (PAGE_SHIFT - 10);
+#endif
+}
+
+static void kmem_reset(void)
+{
+    spin_lock_bh(&kmem_lock);
+    kmem_head = kmem_filled = 0;
+    kmem_worst = -1;
+    spin_unlock_bh(&kmem_lock);
+}
+
+/* Slope per sample × 1000 → KiB per minute at the configured period. */
+static s64 kmem_per_min(s64 slope_milli)
+{
+    return div64_s64(slope_milli * 60,
+                     max_t(unsigned int, READ_ONCE(poll_ms), 10));
+}
+
+static bool kmem_leaking(const struct sh_trend *t, unsigned int n)
+{
+    return kmem_filled >= n && t->slope_milli > 0 &&
+           t->falls <= n / LEAK_DIP_DIV;
+}
+
+/* Tick side (softirq): record one sample, return the worst growth. */
+static u32 kmem_collect(void)
+{
+    unsigned int n = kmem_window();
+    u64 kib[KMEM_COUNT];
+    s64 worst = 0;
+    int c;
+
+    kmem_read(kib);
+    spin_lock(&kmem_lock);
+    for (c = 0; c < KMEM_COUNT; c++)
+        kmem_ring[c][kmem_head] = kib[c];
+    kmem_head = (kmem_head + 1) % SH_TREND_MAX;
+    kmem_filled = min_t(unsigned int, kmem_filled + 1, SH_TREND_MAX);
+    kmem_worst = -1;
+    for (c = 0; c < KMEM_COUNT; c++) {
+        struct sh_trend t;
+
+        sh_trend_fit(kmem_ring[c], SH_TREND_MAX, kmem_head,
+                     min(n, kmem_filled), &t);
+        if (kmem_leaking(&t, n) && t.slope_milli > worst) {
+            worst = t.slope_milli;
+            kmem_worst = c;
+        }
+    }
+    spin_unlock(&kmem_lock);
+    return (u32)clamp_t(s64, kmem_per_min(worst), 0, U32_MAX);
+}
+
+/* ─── Exhaustion forecast (COL_FORECAST) ───────────────────────────────
+ * A free‑memory floor fires too late when memory is draining fast and too
+ * early when it is low but flat.  Each tick records MemAvailable and free
+ * swap (KiB) into a ring, fits a least‑squares line over the last
+ * forecast_window samples and projects when each would reach zero at that
+ * rate.  The result is reported in minutes; a level that is not falling, or
+ * a window not yet full, reports SH_TTE_NEVER.
+ */
+enum forecast_level {
+    FC_MEM,
+    FC_SWAP,
+    FC_COUNT
+};
+
+static unsigned int forecast_window = 60;
+module_param(forecast_window, uint, 0644);
+MODULE_PARM_DESC(forecast_window, "Samples in the exhaustion forecast "
+                 "(8‑256, default 60)");
+
+static u64 fc_ring[FC_COUNT][SH_TREND_MAX];
+static unsigned int fc_head, fc_filled;     /* tick only */
+
+/* Runs before the key is enabled, so no tick is using the ring. */
+static void forecast_reset(void)
+{
+    fc_head = fc_filled = 0;
+}
+
+/* Tick side: record one sample and fill in both forecasts. */
+static void forecast_collect(u32 *mem_min, u32 *swap_min)
+{
+    unsigned int n = clamp_t(unsigned int, READ_ONCE(forecast_window),
+                             8, SH_TREND_MAX);
+    u32 period = max_t(unsigned int, READ_ONCE(poll_ms), 10);
+    u32 tte[FC_COUNT];
+    u64 kib[FC_COUNT];
+    int c;
+
+    kib[FC_MEM]  = (u64)si_mem_available() << (PAGE_SHIFT - 10);
+    kib[FC_SWAP] = (u64)get_nr_swap_pages() << (PAGE_SHIFT - 10);
+    for (c = 0; c < FC_COUNT; c++) {
+        struct sh_trend t;
+
+        fc_ring[c][fc_head] = kib[c];
+        sh_trend_fit(fc_ring[c], SH_TREND_MAX, (fc_head + 1) % SH_TREND_MAX,
+                     min(n, fc_filled + 1), &t);
+        tte[c] = fc_filled + 1 >= n ?
+                 sh_tte_minutes(kib[c], t.slope_milli, period) : SH_TTE_NEVER;
+    }
+    fc_head = (fc_head + 1) % SH_TREND_MAX;
+    fc_filled = min_t(unsigned int, fc_filled + 1, SH_TREND_MAX);
+    *mem_min  = tte[FC_MEM];
+    *swap_min = tte[FC_SWAP];
+}
+
+/* ─── Alert journal ──────────────────────────────────────────────────────
+ * Alert state transitions go into a preallocated ring of JOURNAL_LEN
+ * records with a 64‑bit sequence number that starts at 0 on load, read
+ * through /proc/sys_health_alerts much like /dev/kmsg:
+ *   • every open has its own cursor, starting at the oldest record;
+ *   • read() returns whole records only (‑EINVAL if the buffer cannot hold
+ *     the next one) and blocks unless O_NONBLOCK;
+ *   • a cursor the ring has overrun gets ‑EPIPE once and then continues
+ *     from the oldest record, so gaps are never silent;
+ *   • lseek(fd, seq, SEEK_SET) positions at a sequence number, SEEK_END at
+ *     the next record to be written; the file offset is the cursor;
+ *   • poll() reports POLLIN for pending records, POLLERR|POLLPRI on overrun.
+ */
+#define JOURNAL_LEN  256                    /* records, power of two */
+
+struct journal_reader {
+    struct mutex lock;                      /* serialises read/lseek */
+    u64 seq;
+    char buf[SH_EVENT_MAX_LEN];
+};
+
+static struct sh_alert_event journal[JOURNAL_LEN];
+static u64 journal_next;                    /* seq of the next record */
+static bool journal_closing;                /* unload: release readers */
+static DEFINE_SPINLOCK(journal_lock);      /* guards the three above */
+static DECLARE_WAIT_QUEUE_HEAD(journal_wait);
+static u8 alert_level[SH_METRIC_COUNT];     /* enum sh_severity */
+static DEFINE_SPINLOCK(alert_lock);         /* alert_level + the two below */
+static bool alerts_live;                    /* between init and exit */
+static struct kernfs_node *state_kn[SH_METRIC_COUNT]; /* metrics/<m>/state */
+
+static void alert_uevent_queue(const struct sh_alert_event *e);
+
+static u64 journal_oldest(void)
+{
+    return journal_next > JOURNAL_LEN ? journal_next - JOURNAL_LEN : 0;
+}
+
+static void journal_append(enum sh_metric id, u32 value, int threshold,
+                           enum sh_severity prev, enum sh_severity next,
+                           u64 ts_ms)
+{
+    struct sh_alert_event *e;
+
+    spin_lock_bh(&journal_lock);
+    e = &journal[journal_next & (JOURNAL_LEN - 1)];
+    e->seq       = journal_next++;
+    e->ts_ms     = ts_ms;
+    e->value     = value;
+    e->threshold = threshold;
+    e->metric    = id;
+    e->severity  = next;
+    e->state     = sh_alert_transition(prev, next);
+    alert_uevent_queue(e);
+    spin_unlock_bh(&journal_lock);
+
+    wake_up_interruptible(&journal_wait);
+}
+
+/* Journal every metric in @mask whose severity changed since it was last
+ * evaluated.  Caller holds alert_lock.
+ */
+static void alerts_track_locked(const struct sys_snapshot *s,
+                                const int *thresholds, u32 mask)
+{
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++) {
+        u32 v = sh_snapshot_value(s, i);
+        enum sh_severity sev;
+
+        if (!(mask & BIT(i)))
+            continue;
+        sev = sh_alert_severity(i, v, thresholds[i]);
+        if (sev == alert_level[i])
+            continue;
+        journal_append(i, v, thresholds[i], alert_level[i], sev, s->ts_ms);
+        WRITE_ONCE(alert_level[i], sev);
+        if (state_kn[i])
+            sysfs_notify_dirent(state_kn[i]);   /* atomic‑safe */
+    }
+}
+
+static void alerts_track(const struct sys_snapshot *s, const int *thresholds,
+                         u32 mask)
+{
+    spin_lock_bh(&alert_lock);
+    alerts_track_locked(s, thresholds, mask);
+    spin_unlock_bh(&alert_lock);
+}
+
+static bool journal_ready(struct journal_reader *r)
+{
+    bool ready;
+
+    spin_lock_bh(&journal_lock);
+    ready = READ_ONCE(r->seq) != journal_next || journal_closing;
+    spin_unlock_bh(&journal_lock);
+    return ready;
+}
+
+static int journal_open(struct inode *inode, struct file *file)
+{
+    struct journal_reader *r = kzalloc(sizeof(*r), GFP_KERNEL);
+
+    if (!r)
+        return -ENOMEM;
+    mutex_init(&r->lock);
+    spin_lock_bh(&journal_lock);
+    r->seq = journal_oldest();
+    spin_unlock_bh(&journal_lock);
+    file->f_pos = r->seq;
+    file->private_data = r;
+    return 0;
+}
+
+static ssize_t journal_read(struct file *file, char __user *ubuf,
+                            size_t count, loff_t *ppos)
+{
+    struct journal_reader *r = file->private_data;
+    struct sh_alert_event e;
+    ssize_t done = 0;
+    int ret = 0;
+
+    if (mutex_lock_interruptible(&r->lock))
+        return -ERESTARTSYS;
+
+    for (;;) {
+        size_t len;
+
+        spin_lock_bh(&journal_lock);
+        if (r->seq < journal_oldest()) {
+            /* Report the overrun before any record past the gap. */
+            if (!done) {
+                r->seq = journal_oldest();
+                ret = -EPIPE;
+            }
+            spin_unlock_bh(&journal_lock);
+            break;
+        }
+        if (r->seq == journal_next) {
+            bool closing = journal_closing;
+
+            spin_unlock_bh(&journal_lock);
+            if (done || closing)
+                break;
+            if (file->f_flags & O_NONBLOCK) {
+                ret = -EAGAIN;
+                break;
+            }
+            mutex_unlock(&r->lock);
+            if (wait_event_interruptible(journal_wait, journal_ready(r)))
+                return -ERESTARTSYS;
+            if (mutex_lock_interruptible(&r->lock))
+                return -ERESTARTSYS;
+            continue;
+        }
+        e = journal[r->seq & (JOURNAL_LEN - 1)];
+        spin_unlock_bh(&journal_lock);
+
+        len = sh_format_event(r->buf, sizeof(r->buf), &e);
+        if (len > count - done) {
+            if (!done)
+                ret = -EINVAL;
+            break;
+        }
+        if (copy_to_user(ubuf + done, r->buf, len)) {
+            if (!done)
+                ret = -EFAULT;
+            break;
+        }
+        done += len;
+        r->seq++;
+    }
+
+    *ppos = r->seq;
+    mutex_unlock(&r->lock);
+    return done ? done : ret;
+}
+
+static loff_t journal_lseek(struct file *file, loff_t offset, int whence)
+{
+    struct journal_reader *r = file->private_data;
+    loff_t seq;
+
+    mutex_lock(&r->lock);
+    switch (whence) {
+    case SEEK_SET:
+        seq = offset;
+        break;
+    case SEEK_CUR:
+        seq = r->seq + offset;
+        break;
+    case SEEK_END:
+        spin_lock_bh(&journal_lock);
+        seq = journal_next + offset;
+        spin_unlock_bh(&journal_lock);
+        break;
+    default:
+        seq = -EINVAL;
+    }
+    if (seq < 0)                    /* before sequence 0, or an errno alias */
+        seq = -EINVAL;
+
+    /* Past the end would wait for a sequence number that may never be
+     * reused (e.g. one from before a module reload); refuse it.  Before the
+     * oldest record is allowed and reads back as an overrun.
+     */
+    if (seq >= 0) {
+        spin_lock_bh(&journal_lock);
+        if ((u64)seq > journal_next)
+            seq = -EINVAL;
+        spin_unlock_bh(&journal_lock);
+    }
+    if (seq >= 0) {
+        r->seq = seq;
+        file->f_pos = seq;
+    }
+    mutex_unlock(&r->lock);
+    return seq;
+}
+
+static __poll_t journal_poll(struct file *file, poll_table *wait)
+{
+    struct journal_reader *r = file->private_data;
+    __poll_t mask = 0;
+
+    poll_wait(file, &journal_wait, wait);
+
+    spin_lock_bh(&journal_lock);
+    if (READ_ONCE(r->seq) < journal_oldest())
+        mask = EPOLLIN | EPOLLRDNORM | EPOLLERR | EPOLLPRI;
+    else if (READ_ONCE(r->seq) != journal_next)
+        mask = EPOLLIN | EPOLLRDNORM;
+    spin_unlock_bh(&journal_lock);
+    return mask;
+}
+
+static int journal_release(struct inode *inode, struct file *file)
+{
+    kfree(file->private_data);
+    return 0;
+}
+
+static const struct proc_ops journal_file_ops = {
+    .proc_open    = journal_open,
+    .proc_read    = journal_read,
+    .proc_lseek   = journal_lseek,
+    .proc_poll    = journal_poll,
+    .proc_release = journal_release,
+};
+
+/* proc_remove() waits for in‑flight reads; wake the blocked ones first. */
+static void journal_shutdown(void)
+{
+    spin_lock_bh(&journal_lock);
+    journal_closing = true;
+    spin_unlock_bh(&journal_lock);
+    wake_up_interruptible_all(&journal_wait);
+}
+
+/* ─── Deferred alert emission ────────────────────────────────────────────
+ * printk() can stall for milliseconds behind a slow serial console, so the
+ * timer never calls it.  It pushes one record per breached metric into a
+ * single‑producer/single‑consumer kfifo (lock‑free) and kicks a work item,
+ * which rate‑limits per metric and prints.  A full queue drops the record
+ * and counts it; so do the rate limits.  Both counters are read‑only module
+ * parameters.  Journal transitions reach the same work item through a
+ * second kfifo and go out as uevents.
+ */
+#define ALERT_FIFO_LEN  64          /* records, power of two */
+
+struct alert_msg {
+    u32 value;
+    s32 threshold;
+    u8  metric;                     /* enum sh_metric */
+};
+
+static DEFINE_KFIFO(alert_fifo, struct alert_msg, ALERT_FIFO_LEN);
+static DEFINE_KFIFO(uevent_fifo, struct sh_alert_event, ALERT_FIFO_LEN);
+static struct ratelimit_state alert_rs[SH_METRIC_COUNT];
+static struct ratelimit_state uevent_rs;
+static struct kset *sh_kset;        /* /sys/kernel/sys_health */
+static struct kobject *alerts_kobj; /* …/alerts, sends the uevents */
+static atomic_long_t alerts_dropped;
+static atomic_long_t alerts_ratelimited;
+
+static int alert_count_get(char *buf, const struct kernel_param *kp)
+{
+    return scnprintf(buf, PAGE_SIZE, "%ld\n",
+                     atomic_long_read((atomic_long_t *)kp->arg));
+}
+
+static const struct kernel_param_ops alert_count_ops = {
+    .get = alert_count_get,
+};
+module_param_cb(alerts_dropped, &alert_count_ops, &alerts_dropped, 0444);
+MODULE_PARM_DESC(alerts_dropped, "Alerts lost to a full emission queue");
+module_param_cb(alerts_ratelimited, &alert_count_ops, &alerts_ratelimited,
+                0444);
+MODULE_PARM_DESC(alerts_ratelimited,
+                 "Alerts and uevents suppressed by the rate limits");
+
+static void alert_print(const struct alert_msg *m)
+{
+    switch (m->metric) {
+    case SH_METRIC_MEM_FREE:
+        printk(KERN_WARNING TAG "Alert: free memory %u MiB below %d\n",
+               m->value, m->threshold);
+        break;
+    case SH_METRIC_CPU_LOAD:
+        printk(KERN_WARNING TAG
+               "Alert: 1‑min CPU load %u %% above %d %%\n",
+               m->value, m->threshold);
+        break;
+    case SH_METRIC_IO_RATE:
+        printk(KERN_WARNING TAG
+               "Alert: disk I/O %u sps above %d\n",
+               m->value, m->threshold);
+        break;
+    case SH_METRIC_TICK_LATE:
+        printk(KERN_WARNING TAG
+               "Alert: sampling timer %u us late, above %d\n",
+               m->value, m->threshold);
+        break;
+    case SH_METRIC_WAKEUP_LAT:
+        printk(KERN_WARNING TAG
+               "Alert: wakeup latency p99 %u us above %d\n",
+               m->value, m->threshold);
+        break;
+    case SH_METRIC_HIGHORDER:
+        printk(KERN_WARNING TAG
+               "Alert: %u free order‑%u blocks, below %d\n",
+               m->value, frag_order(), m->threshold);
+        break;
+    case SH_METRIC_MEM_TTE:
+        printk(KERN_WARNING TAG
+               "Alert: available memory forecast to run out in %u min, "
+               "below %d\n", m->value, m->threshold);
+        break;
+    case SH_METRIC_SWAP_TTE:
+        printk(KERN_WARNING TAG
+               "Alert: swap forecast to run out in %u min, below %d\n",
+               m->value, m->threshold);
+        break;
+    case SH_METRIC_KMEM_GROWTH: {
+        int c = READ_ONCE(kmem_worst);
+
+        printk(KERN_WARNING TAG
+               "Alert: kernel %s memory growing %u KiB/min, above %d\n",
+               c >= 0 ? kmem_names[c] : "", m->value, m->threshold);
+        break;
+    }
+    }
+}
+
+/* ─── Alert uevents ───────────────────────────────────────────────────
+ * Each journal transition is also sent as a KOBJ_CHANGE uevent from
+ * /sys/kernel/sys_health/alerts (SUBSYSTEM=sys_health) so udev rules can
+ * start remediation units.  uevent_burst/uevent_interval_ms cap the total
+ * rate across metrics; suppressed events are counted in alerts_ratelimited
+ * and remain in the journal.
+ */
+static void alert_uevent(const struct sh_alert_event *e)
+{
+    char metric[32], value[24], threshold[24], severity[24], state[24];
+    char seq[32];
+    char *envp[] = { metric, value, threshold, severity, state, seq, NULL };
+
+    if (!alerts_kobj)
+        return;
+    uevent_rs.interval = msecs_to_jiffies(READ_ONCE(uevent_interval_ms));
+    uevent_rs.burst    = READ_ONCE(uevent_burst);
+    if (uevent_rs.burst && !__ratelimit(&uevent_rs)) {
+        atomic_long_inc(&alerts_ratelimited);
+        return;
+    }
+
+    snprintf(metric, sizeof(metric), "METRIC=%s", sh_metrics[e->metric].name);
+    snprintf(value, sizeof(value), "VALUE=%u", e->value);
+    snprintf(threshold, sizeof(threshold), "THRESHOLD=%d", e->threshold);
+    snprintf(severity, sizeof(severity), "SEVERITY=%s",
+             sh_severity_names[e->severity]);
+    snprintf(state, sizeof(state), "STATE=%s",
+             sh_alert_state_names[e->state]);
+    snprintf(seq, sizeof(seq), "SEQ=%llu", e->seq);
+    kobject_uevent_env(alerts_kobj, KOBJ_CHANGE, envp);
+}
+
+static void alerts_kobj_release(struct kobject *kobj)
+{
+    kfree(kobj);
+}
+
+static const struct kobj_type alerts_ktype = {
+    .release   = alerts_kobj_release,
+    .sysfs_ops = &kobj_sysfs_ops,
+};
+
+/* A kobject needs a kset to send uevents; kernel_kobj has none. */
+static int alerts_kobj_init(void)
+{
+    struct kobject *kobj;
+    int ret;
+
+    sh_kset = kset_create_and_add("sys_health", NULL, kernel_kobj);
+    if (!sh_kset)
+        return -ENOMEM;
+
+    kobj = kzalloc(sizeof(*kobj), GFP_KERNEL);
+    if (!kobj) {
+        kset_unregister(sh_kset);
+        return -ENOMEM;
+    }
+    kobj->kset = sh_kset;
+    ret = kobject_init_and_add(kobj, &alerts_ktype, NULL, "alerts");
+    if (ret) {
+        kobject_put(kobj);
+        kset_unregister(sh_kset);
+        return ret;
+    }
+    alerts_kobj = kobj;
+    return 0;
+}
+
+static void alerts_kobj_exit(void)
+{
+    kobject_put(alerts_kobj);
+    alerts_kobj = NULL;
+    kset_unregister(sh_kset);
+}
+
+static void alert_work_fn(struct work_struct *work)
+{
+    struct sh_alert_event e;
+    struct alert_msg m;
+
+    while (kfifo_get(&uevent_fifo, &e))
+        alert_uevent(&e);
+
+    while (kfifo_get(&alert_fifo, &m)) {
+        struct ratelimit_state *rs = &alert_rs[m.metric];
+
+        /* Only this work item touches alert_rs; pick up live changes. */
+        rs->interval = msecs_to_jiffies(READ_ONCE(alert_interval_ms));
+        rs->burst    = READ_ONCE(alert_burst);
+        if (rs->burst && !__ratelimit(rs)) {
+            atomic_long_inc(&alerts_ratelimited);
+            continue;
+        }
+        alert_print(&m);
+    }
+}
+
+static DECLARE_WORK(alert_work, alert_work_fn);
+
+/* Timer side: the only kfifo producer. */
+static void alerts_queue(const struct sys_snapshot *s, const int *thresholds,
+                         u32 alerts)
+{
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++) {
+        struct alert_msg m = {
+            .value     = sh_snapshot_value(s, i),
+            .threshold = thresholds[i],
+            .metric    = i,
+        };
+
+        if ((alerts & BIT(i)) && !kfifo_put(&alert_fifo, m))
+            atomic_long_inc(&alerts_dropped);
+    }
+    queue_work(system_unbound_wq, &alert_work);
+}
+
+/* Journal side, called under journal_lock: the single uevent_fifo producer. */
+static void alert_uevent_queue(const struct sh_alert_event *e)
+{
+    if (!READ_ONCE(alert_uevents))
+        return;
+    if (!kfifo_put(&uevent_fifo, *e))
+        atomic_long_inc(&alerts_dropped);
+    queue_work(system_unbound_wq, &alert_work);
+}
+
+static void alerts_init(void)
+{
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++) {
+        ratelimit_state_init(&alert_rs[i], DEFAULT_RATELIMIT_INTERVAL,
+                             DEFAULT_RATELIMIT_BURST);
+        /* We count suppressions ourselves; no "callbacks suppressed". */
+        ratelimit_set_flags(&alert_rs[i], RATELIMIT_MSG_ON_RELEASE);
+    }
+    ratelimit_state_init(&uevent_rs, DEFAULT_RATELIMIT_INTERVAL,
+                         DEFAULT_RATELIMIT_BURST);
+    ratelimit_set_flags(&uevent_rs, RATELIMIT_MSG_ON_RELEASE);
+}
+
+/* ─── Sample history ─────────────────────────────────────────────────────
+ * Every tick appends a sample to a ring of history_len entries, which
+ * /proc/sys_health_history drains in binary as struct sh_record and
+ * /proc/sys_health_query aggregates.  The ring is stored column
+ * by column (times, severities, one array per metric) so that a query
+ * over one metric streams through two dense arrays instead of striding
+ * over whole records; history_get() reassembles a record.  On panic the
+ * newest pstore_samples records are printed, hex‑encoded with a CRC, to the
+ * kernel log.  Panic notifiers run before kmsg_dump(), so ramoops (or any
+ * other pstore backend) saves them with the rest of the log, and
+ * userspace/pstore_decode.py rebuilds the timeline after reboot.  They go
+ * out at KERN_DEBUG to stay off a slow serial console.  pstore keeps only
+ * the newest kmsg_bytes of the log (10240 by default), so the header lines
+ * are printed after the records as well as before, and the default count
+ * keeps the whole dump, at about 220 bytes per record line and 570 per
+ * header, near 8 KiB.
+ */
+static unsigned int history_len = 4096;
+module_param(history_len, uint, 0444);
+MODULE_PARM_DESC(history_len, "Samples kept in the history ring, load‑time "
+                 "only (64‑65536, default 4096)");
+
+static unsigned int pstore_samples = 32;
+module_param(pstore_samples, uint, 0644);
+MODULE_PARM_DESC(pstore_samples, "History records written to the log on "
+                 "panic, for pstore (0=off, default 32)");
+
+static void *history;                   /* one allocation for all columns */
+static u64 *history_time;               /* wall_ms */
+static u32 *history_sev;
+static u32 *history_val[SH_METRIC_COUNT];
+static u64 history_seq;                 /* records ever appended */
+static DEFINE_SPINLOCK(history_lock);
+
+/* ─── Relay stream ──────────────────────────────────────────────────────
+ * With relay_pages set, every record is also written to a relay channel,
+ * debugfs sys_health/samples0: one global buffer of page‑sized sub‑buffers
+ * that streaming captures splice() to a file or socket instead of copying
+ * through read().  Records never straddle a page; relay pads the tail and
+ * strips the padding on the way out.  When the reader falls behind the
+ * channel drops new records (counted in relay_dropped) rather than
+ * overwrite ones it has not consumed.  history_lock serialises writers.
+ */
+static unsigned int relay_pages;
+module_param(relay_pages, uint, 0444);
+MODULE_PARM_DESC(relay_pages, "Page‑sized sub‑buffers in the debugfs relay "
+                 "stream, load‑time only (0=off, 2‑4096)");
+
+static atomic_long_t relay_dropped;
+module_param_cb(relay_dropped, &alert_count_ops, &relay_dropped, 0444);
+MODULE_PARM_DESC(relay_dropped, "Records lost to a full relay stream");
+
+#ifdef CONFIG_RELAY
+static struct dentry *relay_dir;
+static struct rchan *relay_chan;
+
+static int relay_subbuf_start(struct rchan_buf *buf, void *subbuf,
+                              void *prev_subbuf, size_t prev_padding)
+{
+    if (relay_buf_full(buf)) {
+        atomic_long_inc(&relay_dropped);
+        return 0;
+    }
+    return 1;
+}
+
+static struct dentry *relay_create_file(const char *name,
+                                        struct dentry *parent, umode_t mode,
+                                        struct rchan_buf *buf, int *is_global)
+{
+    *is_global = 1;
+    return debugfs_create_file(name, 0400, parent, buf,
+                               &relay_file_operations);
+}
+
+static int relay_remove_file(struct dentry *dentry)
+{
+    debugfs_remove(dentry);
+    return 0;
+}
+
+static const struct rchan_callbacks relay_cbs = {
+    .subbuf_start    = relay_subbuf_start,
+    .create_buf_file = relay_create_file,
+    .remove_buf_file = relay_remove_file,
+};
+
+/* Optional: the module loads anyway when debugfs is unavailable. */
+static void relay_stream_init(void)
+{
+    if (!relay_pages)
+        return;
+    relay_pages = clamp_t(unsigned int, relay_pages, 2, 4096);
+    relay_dir = debugfs_create_dir("sys_health", NULL);
+    if (!IS_ERR_OR_NULL(relay_dir))
+        relay_chan = relay_open("samples", relay_dir, PAGE_SIZE,
+                                relay_pages, &relay_cbs, NULL);
+    if (!relay_chan) {
+        printk(KERN_WARNING TAG "relay stream unavailable\n");
+        debugfs_remove(relay_dir);
+        relay_dir = NULL;
+    }
+}
+
+static void relay_stream_exit(void)
+{
+    if (relay_chan)
+        relay_close(relay_chan);
+    relay_chan = NULL;
+    debugfs_remove(relay_dir);
+    relay_dir = NULL;
+}
+
+/* Under history_lock. */
+static void relay_stream_write(const struct sh_record *r)
+{
+    if (relay_chan)
+        relay_write(relay_chan, r, sizeof(*r));
+}
+#else
+static void relay_stream_init(void)
+{
+    if (relay_pages)
+        printk(KERN_WARNING TAG "relay stream needs CONFIG_RELAY\n");
+}
+
+static void relay_stream_exit(void) { }
+static void relay_stream_write(const struct sh_record *r) { }
+#endif
+
+/* ─── mmap ring ─────────────────────────────────────────────────────────
+ * With mmap_pages set, every record is also copied into a vmalloc_user()
+ * area that /proc/sys_health_ring maps read‑only: a control page (struct
+ * sh_ring_page) and mmap_pages pages of record slots.  As in perf's ring
+ * the kernel fills the slot and then publishes head with a release store,
+ * so consumers follow the stream at any pace without a syscall and tell
+ * an overrun from the sequence numbers (sys_health_uapi.h has the rules,
+ * userspace/sh_ring.h the reader).  Nothing is ever read back from the
+ * mapping; history_lock serialises writers.
+ */
+static unsigned int mmap_pages;
+module_param(mmap_pages, uint, 0444);
+MODULE_PARM_DESC(mmap_pages, "Data pages of the /proc/sys_health_ring mmap "
+                 "ring, load‑time only (0=off, 1‑4096)");
+
+static struct sh_ring_page *ring_ctl;   /* control page, then the slots */
+static struct sh_record *ring_data;
+static u32 ring_slots;
+
+static int ring_init(void)
+{
+    size_t data;
+
+    if (!mmap_pages)
+        return 0;
+    mmap_pages = min_t(unsigned int, mmap_pages, 4096);
+    data = (size_t)mmap_pages << PAGE_SHIFT;
+    ring_ctl = vmalloc_user(PAGE_SIZE + data);    /* zeroed */
+    if (!ring_ctl)
+        return -ENOMEM;
+    ring_data = (struct sh_record *)((char *)ring_ctl + PAGE_SIZE);
+    ring_slots = data / sizeof(struct sh_record);
+
+    ring_ctl->version     = SH_RECORD_VERSION;
+    ring_ctl->record_size = sizeof(struct sh_record);
+    ring_ctl->nr_records  = ring_slots;
+    ring_ctl->data_offset = PAGE_SIZE;
+    ring_ctl->data_size   = (u64)ring_slots * sizeof(struct sh_record);
+    return 0;
+}
+
+static void ring_exit(void)
+{
+    vfree(ring_ctl);                /* mapped pages hold their own refs */
+    ring_ctl = NULL;
+}
+
+/* Under history_lock; r->seq is the next head. */
+static void ring_write(const struct sh_record *r)
+{
+    u64 seq = r->seq;
+
+    if (!ring_ctl)
+        return;
+    WRITE_ONCE(ring_ctl->tail, seq + 1 > ring_slots ? seq + 1 - ring_slots
+                                                    : 0);
+    smp_wmb();                      /* tail moves before the slot changes */
+    ring_data[seq % ring_slots] = *r;
+    smp_store_release(&ring_ctl->head, seq + 1);
+}
+
+static int ring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_clear(vma, VM_MAYWRITE);
+#else
+    vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+    return remap_vmalloc_range(vma, ring_ctl, vma->vm_pgoff);
+}
+
+static const struct proc_ops ring_file_ops = {
+    .proc_mmap    = ring_mmap,
+};
+
+static int history_init(void)
+{
+    int i;
+
+    history_len = clamp_t(unsigned int, history_len, 64, 65536);
+    history = kvcalloc(history_len, sizeof(u64) +
+                       (1 + SH_METRIC_COUNT) * sizeof(u32), GFP_KERNEL);
+    if (!history)
+        return -ENOMEM;
+    history_time = history;
+    history_sev  = (u32 *)(history_time + history_len);
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        history_val[i] = history_sev + (i + 1) * history_len;
+    if (ring_init()) {
+        kvfree(history);
+        history = NULL;
+        return -ENOMEM;
+    }
+    relay_stream_init();
+    return 0;
+}
+
+static void history_exit(void)
+{
+    relay_stream_exit();
+    ring_exit();
+    kvfree(history);
+    history = NULL;
+}
+
+/* Under history_lock, or with the other CPUs stopped. */
+static void history_get(u64 seq, struct sh_record *r)
+{
+    u32 idx = seq % history_len;
+    int i;
+
+    memset(r, 0, sizeof(*r));
+    r->seq      = seq;
+    r->wall_ms  = history_time[idx];
+    r->severity = history_sev[idx];
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        r->value[i] = history_val[i][idx];
+}
+
+/* Tick side (softirq), after alerts_track() has updated alert_level[]. */
+static void history_append(const struct sys_snapshot *s)
+{
+    u8 levels[SH_METRIC_COUNT];
+    struct sh_record r;
+    u32 idx;
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        levels[i] = READ_ONCE(alert_level[i]);
+    spin_lock(&history_lock);
+    sh_record_fill(&r, history_seq, s, levels);
+    idx = history_seq % history_len;
+    history_time[idx] = r.wall_ms;
+    history_sev[idx]  = r.severity;
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        history_val[i][idx] = r.value[i];
+    relay_stream_write(&r);
+    ring_write(&r);
+    WRITE_ONCE(history_seq, history_seq + 1);
+    spin_unlock(&history_lock);
+}
+
+static struct sh_record history_panic_rec;
+static char history_hex[2 * sizeof(struct sh_record) + 1];
+
+static void history_panic_header(u64 end)
+{
+    int i;
+
+    printk(KERN_DEBUG TAG "SHM1 H %d %u %zu %u %s %llu\n",
+           SH_RECORD_VERSION, SH_METRIC_COUNT, sizeof(struct sh_record),
+           READ_ONCE(poll_ms),
+           IS_ENABLED(CONFIG_CPU_BIG_ENDIAN) ? "be" : "le", end);
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        printk(KERN_DEBUG TAG "SHM1 M %d %s %s\n", i, sh_metrics[i].name,
+               sh_metrics[i].unit);
+}
+
+/* Other CPUs are stopped, possibly inside history_append(), so no lock.
+ * A sample being appended is not yet below history_seq, but it overwrites
+ * the oldest one, which is left out when the lock is held.  The CRC
+ * catches lines torn on the way to pstore; the trailing header survives
+ * when a larger pstore_samples pushes the leading one out of kmsg_bytes.
+ */
+static int history_panic(struct notifier_block *nb, unsigned long event,
+                         void *unused)
+{
+    u64 end = READ_ONCE(history_seq), seq;
+    unsigned int n;
+
+    n = min_t(unsigned int, READ_ONCE(pstore_samples),
+              history_len - spin_is_locked(&history_lock));
+    n = min_t(u64, n, end);
+    if (!n)
+        return NOTIFY_DONE;
+
+    history_panic_header(end);
+    for (seq = end - n; seq < end; seq++) {
+        const struct sh_record *r = &history_panic_rec;
+
+        history_get(seq, &history_panic_rec);
+        *bin2hex(history_hex, r, sizeof(*r)) = '\0';
+        printk(KERN_DEBUG TAG "SHM1 R %08x %s\n",
+               ~crc32_le(~0, (const u8 *)r, sizeof(*r)), history_hex);
+    }
+    history_panic_header(end);
+    return NOTIFY_DONE;
+}
+
+static struct notifier_block history_panic_nb = {
+    .notifier_call = history_panic,
+};
+
+/* ─── On‑demand collection ──────────────────────────────────────────────
+ * With ondemand=1 the timer only refreshes memory and load (cheap, and what
+ * alerting needs between reads) and stops altogether when no threshold is
+ * enabled.  Readers of /proc/sys_health and the sysfs value files collect
+ * everything themselves when the oldest value they would be served is more
+ * than read_ttl_ms old.  collect_mutex makes concurrent readers coalesce:
+ * the first one collects, the others wait for it and find a fresh sample.
+ * A read‑triggered sample is alert‑tracked (journal, uevent, sysfs state)
+ * but does not print; printed alerts stay with the timer.
+ */
+static DEFINE_MUTEX(collect_mutex);
+static DEFINE_SPINLOCK(collect_lock);   /* disk state: timer vs readers */
+
+static void collect_disk(struct sh_budget *b)
+{
+    spin_lock_bh(&collect_lock);
+    if (collector_on(COL_DISK)) {
+        if (collector_on(COL_NUMA_IO))
+            collect_disk_ios_numa();
+        else
+            collect_disk_ios(b);
+    } else {
+        last_io_ticks    = 0;       /* re‑prime the delta when re‑enabled */
+        last_io_rate     = 0;
+        last_io_fresh_ms = 0;
+        sh_cursor_finish(&disk_cursor);
+    }
+    spin_unlock_bh(&collect_lock);
+}
+
+/* Age in ms of the oldest value in @s (jiffies‑based ms wrap at 2^32). */
+static u32 snapshot_age_ms(const struct sys_snapshot *s)
+{
+    u32 now = jiffies_to_msecs(jiffies), age = 0;
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++) {
+        if (i == SH_METRIC_IO_RATE && !collector_on(COL_DISK))
+            continue;
+        if (i == SH_METRIC_HIGHORDER && !collector_on(COL_FRAG))
+            continue;
+        if (i == SH_METRIC_TICK_LATE || i == SH_METRIC_WAKEUP_LAT ||
+            i == SH_METRIC_KMEM_GROWTH || i == SH_METRIC_MEM_TTE ||
+            i == SH_METRIC_SWAP_TTE)
+            continue;                   /* only a tick refreshes these */
+        age = max_t(u32, age, now - (u32)s->fresh_ms[i]);
+    }
+    return age;
+}
+
+static void collect_now(void)
+{
+    int thresholds[SH_METRIC_COUNT];
+    struct sys_snapshot tmp, prev;
+    struct sh_budget budget;
+
+    sh_budget_start(&budget, ktime_get_ns(), 0);    /* reader waits anyway */
+    collect_memory(&tmp.free_mem_mib, &tmp.total_mem_mib);
+    tmp.load_pct = collect_load_percent();
+    tmp.highorder_blocks = collector_on(COL_FRAG) ? frag_collect() : 0;
+    collect_disk(&budget);
+
+    spin_lock_bh(&collect_lock);
+    tmp.io_rate_sps = last_io_rate;
+    tmp.fresh_ms[SH_METRIC_IO_RATE] = last_io_fresh_ms;
+    spin_unlock_bh(&collect_lock);
+
+    tmp.ts_ms = jiffies_to_msecs(jiffies);
+    tmp.fresh_ms[SH_METRIC_MEM_FREE] = tmp.ts_ms;
+    tmp.fresh_ms[SH_METRIC_CPU_LOAD] = tmp.ts_ms;
+    tmp.fresh_ms[SH_METRIC_HIGHORDER] = tmp.ts_ms;
+    tmp.wall_ms = div_u64(ktime_get_real_ns(), NSEC_PER_MSEC);
+    snapshot_read(&prev);           /* tick‑only metrics keep last values */
+    tmp.late_us = prev.late_us;
+    tmp.fresh_ms[SH_METRIC_TICK_LATE] = prev.fresh_ms[SH_METRIC_TICK_LATE];
+    tmp.wakeup_us = prev.wakeup_us;
+    tmp.fresh_ms[SH_METRIC_WAKEUP_LAT] = prev.fresh_ms[SH_METRIC_WAKEUP_LAT];
+    tmp.kmem_growth = prev.kmem_growth;
+    tmp.fresh_ms[SH_METRIC_KMEM_GROWTH] = prev.fresh_ms[SH_METRIC_KMEM_GROWTH];
+    tmp.mem_tte_min  = prev.mem_tte_min;
+    tmp.swap_tte_min = prev.swap_tte_min;
+    tmp.fresh_ms[SH_METRIC_MEM_TTE]  = prev.fresh_ms[SH_METRIC_MEM_TTE];
+    tmp.fresh_ms[SH_METRIC_SWAP_TTE] = prev.fresh_ms[SH_METRIC_SWAP_TTE];
+    snapshot_publish(&tmp);
+
+    thresholds_read(thresholds);
+    alerts_track(&tmp, thresholds, BIT(SH_METRIC_COUNT) - 1);
+}
+
+/*
+ * Readers' entry point: the cached snapshot, refreshed first if stale.  Not
+ * refreshed outside init..exit, when the workers collect_now() needs may
+ * be gone.
+ */
+static void snapshot_get(struct sys_snapshot *out)
+{
+    snapshot_read(out);
+    if (!READ_ONCE(ondemand) || !READ_ONCE(alerts_live) ||
+        snapshot_age_ms(out) <= READ_ONCE(read_ttl_ms))
+        return;
+
+    if (mutex_lock_killable(&collect_mutex))
+        return;                     /* serve the cached one */
+    snapshot_read(out);             /* someone may have beaten us to it */
+    if (snapshot_age_ms(out) > READ_ONCE(read_ttl_ms)) {
+        collect_now();
+        snapshot_read(out);
+    }
+    mutex_unlock(&collect_mutex);
+}
+
+static void align_resume(void);
+
+static void poll_start(void)
+{
+    hrtimer_start(&poll_timer, ktime_add_ns(ktime_get(), poll_period_ns()),
+                  HRTIMER_MODE_ABS_SOFT);
+}
+
+/* Re‑arms a timer that on‑demand mode stopped; no‑op while it is queued.
+ * alert_lock orders this against poll_metrics() moving the expiry.
+ */
+static void poll_resume(void)
+{
+    spin_lock_bh(&alert_lock);
+    if (alerts_live && align_wallclock)
+        align_resume();
+    else if (alerts_live && !hrtimer_is_queued(&poll_timer))
+        poll_start();
+    spin_unlock_bh(&alert_lock);
+}
+
+/* ─── Per‑metric sysfs tree ──────────────────────────────────────────────
+ * /sys/kernel/sys_health/metrics/<name>/{value,threshold,state}: one small
+ * file per value so tools need not parse /proc/sys_health.  `state` (info,
+ * warning or critical) is sysfs_notify()'d on every transition, so poll()
+ * on it (POLLPRI|POLLERR after a read) waits for one metric's alerts.
+ * `threshold` is the same variable as the <metric>_threshold parameter.
+ */
+struct metric_kobj {
+    struct kobject kobj;
+    enum sh_metric id;
+};
+
+static struct kobject *metrics_kobj;
+static struct metric_kobj *metric_kobjs[SH_METRIC_COUNT];
+
+static void alerts_reevaluate(u32 mask)
+{
+    int thresholds[SH_METRIC_COUNT];
+    struct sys_snapshot s;
+
+    /* alert_lock also holds off exit while we touch the snapshot. */
+    spin_lock_bh(&alert_lock);
+    if (alerts_live) {      /* not for load‑time parameters */
+        snapshot_read(&s);
+        thresholds_read(thresholds);
+        alerts_track_locked(&s, thresholds, mask);
+    }
+    spin_unlock_bh(&alert_lock);
+    poll_resume();                  /* a newly armed threshold needs it */
+}
+
+static void alerts_reevaluate_param(const int *threshold)
+{
+    int i;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++)
+        if (metric_threshold[i] == threshold)
+            alerts_reevaluate(BIT(i));
+}
+
+static enum sh_metric to_metric(struct kobject *kobj)
+{
+    return container_of(kobj, struct metric_kobj, kobj)->id;
+}
+
+static ssize_t value_show(struct kobject *kobj, struct kobj_attribute *attr,
+                          char *buf)
+{
+    struct sys_snapshot s;
+
+    snapshot_get(&s);
+    return scnprintf(buf, PAGE_SIZE, "%u\n",
+                     sh_snapshot_value(&s, to_metric(kobj)));
+}
+
+static ssize_t threshold_show(struct kobject *kobj,
+                              struct kobj_attribute *attr, char *buf)
+{
+    return scnprintf(buf, PAGE_SIZE, "%d\n",
+                     READ_ONCE(*metric_threshold[to_metric(kobj)]));
+}
+
+static ssize_t threshold_store(struct kobject *kobj,
+                               struct kobj_attribute *attr,
+                               const char *buf, size_t count)
+{
+    enum sh_metric id = to_metric(kobj);
+    int val, ret = kstrtoint(buf, 0, &val);
+
+    if (ret)
+        return ret;
+    WRITE_ONCE(*metric_threshold[id], val);
+    alerts_reevaluate(BIT(id));
+    return count;
+}
+
+static ssize_t state_show(struct kobject *kobj, struct kobj_attribute *attr,
+                          char *buf)
+{
+    return scnprintf(buf, PAGE_SIZE, "%s\n",
+                     sh_severity_names[READ_ONCE(alert_level[to_metric(kobj)])]);
+}
+
+static struct kobj_attribute value_attr     = __ATTR_RO(value);
+static struct kobj_attribute threshold_attr = __ATTR_RW(threshold);
+static struct kobj_attribute state_attr     = __ATTR_RO(state);
+
+static struct attribute *metric_attrs[] = {
+    &value_attr.attr,
+    &threshold_attr.attr,
+    &state_attr.attr,
+    NULL,
+};
+ATTRIBUTE_GROUPS(metric);
+
+static void metric_kobj_release(struct kobject *kobj)
+{
+    kfree(container_of(kobj, struct metric_kobj, kobj));
+}
+
+static const struct kobj_type metric_ktype = {
+    .release        = metric_kobj_release,
+    .sysfs_ops      = &kobj_sysfs_ops,
+    .default_groups = metric_groups,
+};
+
+static void metrics_sysfs_exit(void)
+{
+    struct kernfs_node *kn[SH_METRIC_COUNT];
+    int i;
+
+    spin_lock_bh(&alert_lock);
+    memcpy(kn, state_kn, sizeof(kn));
+    memset(state_kn, 0, sizeof(state_kn));
+    spin_unlock_bh(&alert_lock);
+
+    for (i = 0; i < SH_METRIC_COUNT; i++) {
+        sysfs_put(kn[i]);
+        if (metric_kobjs[i])
+            kobject_put(&metric_kobjs[i]->kobj);
+        metric_kobjs[i] = NULL;
+    }
+    kobject_put(metrics_kobj);
+    metrics_kobj = NULL;
+}
+
+static int metrics_sysfs_init(void)
+{
+    struct kernfs_node *kn;
+    int i, ret;
+
+    metrics_kobj = kobject_create_and_add("metrics", &sh_kset->kobj);
+    if (!metrics_kobj)
+        return -ENOMEM;
+
+    for (i = 0; i < SH_METRIC_COUNT; i++) {
+        struct metric_kobj *mk = kzalloc(sizeof(*mk), GFP_KERNEL);
+
+        ret = -ENOMEM;
+        if (!mk)
+            goto err;
+        mk->id = i;
+        ret = kobject_init_and_add(&mk->kobj, &metric_ktype, metrics_kobj,
+                                   "%s", sh_metrics[i].name);
+        if (ret) {
+            kobject_put(&mk->kobj);
+            goto err;
+        }
+        metric_kobjs[i] = mk;
+        kn = sysfs_get_dirent(mk->kobj.sd, "state");
+        spin_lock_bh(&alert_lock);
+        state_kn[i] = kn;
+        spin_unlock_bh(&alert_lock);
+    }
+    return 0;
+
+err:
+    metrics_sysfs_exit();
+    return ret;
+}
+
+/* ─── Sampling tick ──────────────────────────────────────────────────────── */
+static u64 last_tick_ms;            /* ts_ms of the previous sample_tick() */
+
+/* Takes and publishes one sample, from the timer (softirq) only.  @late_ns
+ * is how late this tick fired against its schedule.  Returns false when
+ * on‑demand mode lets the timer stop.
+ */
+static bool sample_tick(u64 late_ns)
+{
+    struct sys_snapshot tmp;
+    struct sh_budget budget;
+    bool timed = collector_on(COL_TIMING);
+    u64 t0 = ktime_get_ns(), t1 = t0, ns[TS_COUNT];
+    int thresholds[SH_METRIC_COUNT];
+    u32 alerts, fresh;
+
+    sh_budget_start(&budget, t0,
+                    (u64)READ_ONCE(tick_budget_us) * NSEC_PER_USEC);
+
+    /* Cheap global metrics: read in full on every tick. */
+    collect_memory(&tmp.free_mem_mib, &tmp.total_mem_mib);
+    if (timed) {
+        t1 = ktime_get_ns();
+        ns[TS_MEMORY] = t1 - t0;
+    }
+
+    tmp.load_pct     = collect_load_percent();
+    if (timed) {
+        ns[TS_LOAD] = ktime_get_ns() - t1;
+        t1 += ns[TS_LOAD];
+    }
+
+    /* Large‑set collectors: bounded by the tick budget, may lag a tick.
+     * In on‑demand mode they run only when a reader asks for them.
+     */
+    if (!READ_ONCE(ondemand))
+        collect_disk(&budget);
+    tmp.io_rate_sps = last_io_rate;
+    if (timed) {
+        ns[TS_DISK]  = ktime_get_ns() - t1;
+    }
+
+    tmp.ts_ms        = jiffies_to_msecs(jiffies);
+    tmp.fresh_ms[SH_METRIC_MEM_FREE] = tmp.ts_ms;
+    tmp.fresh_ms[SH_METRIC_CPU_LOAD] = tmp.ts_ms;
+    tmp.fresh_ms[SH_METRIC_IO_RATE]  = last_io_fresh_ms;
+    tmp.wall_ms  = div_u64(ktime_get_real_ns(), NSEC_PER_MSEC);
+    tmp.late_us  = (u32)min_t(u64, div_u64(late_ns, NSEC_PER_USEC), U32_MAX);
+    tmp.fresh_ms[SH_METRIC_TICK_LATE] = tmp.ts_ms;
+    tmp.wakeup_us = collector_on(COL_WAKEUP) ? wakeup_collect() : 0;
+    tmp.fresh_ms[SH_METRIC_WAKEUP_LAT] = tmp.ts_ms;
+    tmp.highorder_blocks = collector_on(COL_FRAG) ? frag_collect() : 0;
+    tmp.fresh_ms[SH_METRIC_HIGHORDER] = tmp.ts_ms;
+    tmp.kmem_growth = collector_on(COL_KMEM) ? kmem_collect() : 0;
+    tmp.fresh_ms[SH_METRIC_KMEM_GROWTH] = tmp.ts_ms;
+    tmp.mem_tte_min = tmp.swap_tte_min = SH_TTE_NEVER;
+    if (collector_on(COL_FORECAST))
+        forecast_collect(&tmp.mem_tte_min, &tmp.swap_tte_min);
+    tmp.fresh_ms[SH_METRIC_MEM_TTE]  = tmp.ts_ms;
+    tmp.fresh_ms[SH_METRIC_SWAP_TTE] = tmp.ts_ms;
+
+    spin_lock(&timing_lock);
+    sh_hist_add(&late_hist, tmp.late_us);
+    spin_unlock(&timing_lock);
+
+    snapshot_publish(&tmp);
+
+    /* Judge only values collected since the last tick.  In on‑demand mode
+     * collect_disk() is skipped and Io_rate would otherwise repeat (and
+     * keep alerting on) whatever a reader last fetched.
+     */
+    fresh = (BIT(SH_METRIC_COUNT) - 1) & ~sh_stale_mask(&tmp, last_tick_ms);
+    last_tick_ms = tmp.ts_ms;
+    thresholds_read(thresholds);
+    alerts = sh_eval_alerts(&tmp, thresholds) & fresh;
+    alerts_track(&tmp, thresholds, fresh);
+
+    if (alerts)
+        alerts_queue(&tmp, thresholds, alerts);
+    history_append(&tmp);
+
+    /* Total covers the whole tick, not just the three stages above. */
+    if (timed) {
+        ns[TS_TOTAL] = ktime_get_ns() - t0;
+        ns[TS_LATE]  = late_ns;
+        timing_record(ns);
+    }
+
+    /* With nothing to alert on, on‑demand mode needs no timer at all;
+     * poll_resume() restarts it when a threshold or the mode changes.
+     */
+    return !(READ_ONCE(ondemand) && !sh_alerts_armed(thresholds));
+}
+
+/* ─── Wall‑clock alignment (align_wallclock=1) ──────────────────────────
+ * Ticks come from a soft (softirq) hrtimer on CLOCK_REALTIME in absolute
+ * mode, armed for the next multiple of poll_ms since the epoch, so hosts
+ * with NTP‑synced clocks sample at the same instants.  Each tick computes
+ * the next boundary from the current time rather than adding a period, so
+ * a resume from suspend or a forward clock step (which make the absolute
+ * timer expire at once) realigns on the next tick.  A backward step would
+ * instead push the expiry out by the size of the step, so a jiffies timer
+ * is kept as a watchdog two periods ahead; if it fires, the hrtimer is
+ * re‑armed from the current time.  Either kind of jump is counted in
+ * align_realigns.  The lateness of every tick against its boundary goes
+ * into the snapshot (Tick_late) and, with timing on, the timer_late row.
+ */
+static struct hrtimer align_timer;
+static ktime_t align_expected;      /* boundary the hrtimer is armed for */
+static atomic_long_t align_realigns;
+
+module_param_cb(align_realigns, &alert_count_ops, &align_realigns, 0444);
+MODULE_PARM_DESC(align_realigns,
+                 "Aligned ticks that had to resync after a clock jump");
+
+static void align_watchdog_arm(void)
+{
+    mod_timer(&align_watchdog, jiffies + 2 * poll_period_jiffies());
+}
+
+static void align_start(void)
+{
+    align_expected = ns_to_ktime(sh_align_next(ktime_get_real_ns(),
+                                               poll_period_ns()));
+    hrtimer_start(&align_timer, align_expected, HRTIMER_MODE_ABS_SOFT);
+    align_watchdog_arm();
+}
+
+static void align_resume(void)
+{
+    if (!hrtimer_active(&align_timer))
+        align_start();
+}
+
+static enum hrtimer_restart align_fire(struct hrtimer *t)
+{
+    ktime_t now = ktime_get_real();
+    s64 late = ktime_to_ns(ktime_sub(now, align_expected));
+    u64 period = poll_period_ns();
+
+    if (late > (s64)period)         /* suspend or forward step */
+        atomic_long_inc(&align_realigns);
+
+    if (!sample_tick(max_t(s64, late, 0))) {
+        del_timer(&align_watchdog); /* stopped on purpose: no watchdog */
+        return HRTIMER_NORESTART;
+    }
+
+    align_expected = ns_to_ktime(sh_align_next(ktime_to_ns(now), period));
+    hrtimer_set_expires(t, align_expected);
+    align_watchdog_arm();
+    return HRTIMER_RESTART;
+}
+
+static void align_init(void)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+    hrtimer_setup(&align_timer, align_fire, CLOCK_REALTIME,
+                  HRTIMER_MODE_ABS_SOFT);
+#else
+    hrtimer_init(&align_timer, CLOCK_REALTIME, HRTIMER_MODE_ABS_SOFT);
+    align_timer.function = align_fire;
+#endif
+}
+
+/* ─── Timer callback (poll_ms) ─────────────────────────────────────────── */
+/* A soft hrtimer on CLOCK_MONOTONIC, so lateness is measured against the
+ * deadline to the nanosecond rather than to a timer‑wheel bucket.  It is
+ * re‑armed on a fixed schedule with hrtimer_forward(), deadline plus
+ * period rather than relative to when the callback ran, so lateness never
+ * accumulates into drift.  Periods already over are skipped (and counted)
+ * instead of being fired back to back.
+ */
+static enum hrtimer_restart poll_metrics(struct hrtimer *t)
+{
+    s64 late = ktime_to_ns(ktime_sub(ktime_get(), hrtimer_get_expires(t)));
+    enum hrtimer_restart ret = HRTIMER_NORESTART;
+    u64 missed;
+
+    if (!sample_tick(max_t(s64, late, 0)))
+        return HRTIMER_NORESTART;
+
+    spin_lock(&alert_lock);
+    if (!hrtimer_is_queued(t)) {    /* poll_resume() may have beaten us */
+        missed = hrtimer_forward_now(t, ns_to_ktime(poll_period_ns())) - 1;
+        if (missed) {
+            spin_lock(&timing_lock);
+            late_missed += missed;
+            spin_unlock(&timing_lock);
+        }
+        ret = HRTIMER_RESTART;
+    }
+    spin_unlock(&alert_lock);
+    return ret;
+}
+
+/* Watchdog: the hrtimer missed two periods (clock stepped back).  A
+ * running callback (‑1) re‑arms us itself.
+ */
+static void align_watchdog_fire(struct timer_list *t)
+{
+    if (READ_ONCE(alerts_live) &&
+        hrtimer_try_to_cancel(&align_timer) >= 0) {
+        atomic_long_inc(&align_realigns);
+        align_start();
+    }
+}
+
+static void poll_init(void)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+    hrtimer_setup(&poll_timer, poll_metrics, CLOCK_MONOTONIC,
+                  HRTIMER_MODE_ABS_SOFT);
+#else
+    hrtimer_init(&poll_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_SOFT);
+    poll_timer.function = poll_metrics;
+#endif
+    timer_setup(&align_watchdog, align_watchdog_fire, 0);
+}
+
+/* ─── Cgroup‑scoped view (cgroup_view=1) ────────────────────────────────
+ * Readers outside the initial cgroup namespace see memory against their
+ * memcg's effective memory.max (the tightest limit between it and the
+ * root) and get the number of CPUs they may run on, which is the cpuset
+ * narrowed by affinity.  An unlimited memcg reports host memory, as lxcfs
+ * does.  CPU load and the I/O rate stay host‑wide: cpu.max quotas and
+ * io.stat live in scheduler and blk‑cgroup internals a module can't reach.
+ * The memory figures are cached per cgroup for one published snapshot, so
+ * a container polling /proc costs one memcg walk per tick, not per read.
+ */
+static bool cgroup_view = true;
+module_param(cgroup_view, bool, 0644);
+MODULE_PARM_DESC(cgroup_view,
+                 "Scope /proc/sys_health to the reader's cgroup inside "
+                 "cgroup namespaces (default 1)");
+
+#define CG_CACHE_LEN  16
+
+struct cg_view {
+    u64 cgid;
+    u64 snap_ts;                /* ts_ms of the snapshot it was built on */
+    u32 free_mib;
+    u32 total_mib;
+};
+
+static struct cg_view cg_cache[CG_CACHE_LEN];
+static unsigned int cg_cache_next;
+static DEFINE_SPINLOCK(cg_cache_lock);
+
+static bool cg_view_wanted(void)
+{
+    return READ_ONCE(cgroup_view) && current->nsproxy &&
+           current->nsproxy->cgroup_ns != init_task.nsproxy->cgroup_ns;
+}
+
+/* Without CONFIG_MEMCG there is no limit to scope to: host totals. */
+static void cg_view_compute(const struct sys_snapshot *s, struct cg_view *v)
+{
+#ifdef CONFIG_MEMCG
+    unsigned long limit = PAGE_COUNTER_MAX, usage;
+    struct mem_cgroup *memcg, *iter;
+#endif
+
+    v->free_mib  = s->free_mem_mib;
+    v->total_mib = s->total_mem_mib;
+#ifdef CONFIG_MEMCG
+    if (mem_cgroup_disabled() || !current->mm)
+        return;
+    memcg = get_mem_cgroup_from_mm(current->mm);
+    if (!memcg)
+        return;
+    for (iter = memcg; iter && !mem_cgroup_is_root(iter);
+         iter = parent_mem_cgroup(iter))
+        limit = min(limit, READ_ONCE(iter->memory.max));
+    if (limit != PAGE_COUNTER_MAX) {
+        usage = min(page_counter_read(&memcg->memory), limit);
+        v->total_mib = min(v->total_mib,
+                           sh_pages_to_mib(limit, PAGE_SHIFT));
+        v->free_mib  = min(v->free_mib,
+                           sh_pages_to_mib(limit - usage, PAGE_SHIFT));
+    }
+    mem_cgroup_put(memcg);
+#endif
+}
+
+/* Rewrites @s for the calling task; returns its cgroup id. */
+static u64 cg_view_apply(struct sys_snapshot *s)
+{
+    struct cg_view v = { 0 };
+    unsigned int i;
+    bool hit = false;
+
+    rcu_read_lock();
+    v.cgid = cgroup_id(task_dfl_cgroup(current));
+    rcu_read_unlock();
+    v.snap_ts = s->ts_ms;
+
+    spin_lock(&cg_cache_lock);
+    for (i = 0; i < CG_CACHE_LEN; i++) {
+        if (cg_cache[i].cgid == v.cgid && cg_cache[i].snap_ts == v.snap_ts) {
+            v = cg_cache[i];
+            hit = true;
+            break;
+        }
+    }
+    spin_unlock(&cg_cache_lock);
+
+    if (!hit) {
+        cg_view_compute(s, &v);
+        spin_lock(&cg_cache_lock);
+        cg_cache[cg_cache_next] = v;
+        cg_cache_next = (cg_cache_next + 1) % CG_CACHE_LEN;
+        spin_unlock(&cg_cache_lock);
+    }
+    s->free_mem_mib  = v.free_mib;
+    s->total_mem_mib = v.total_mib;
+    return v.cgid;
+}
+
+/* ─── /proc reader ─────────────────────────────────────────────────────── */
+static int proc_show(struct seq_file *m, void *v)
+{
+    struct sys_snapshot s;
+    char buf[512];
+
+    bool scoped = cg_view_wanted();
+    u64 cgid = 0;
+
+    snapshot_get(&s);
+    if (scoped)
+        cgid = cg_view_apply(&s);
+    sh_format_snapshot(buf, sizeof(buf), &s);
+    seq_puts(m, buf);
+    if (scoped)
+        seq_printf(m, "Cgroup_id    : %llu\n"
+                   "CPUs_allowed : %u\n",
+                   cgid, cpumask_weight(current->cpus_ptr));
+    return 0;
+}
+
+static int proc_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, proc_show, NULL);
+}
+
+static const struct proc_ops proc_file_ops = {
+    .proc_open    = proc_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* ─── /proc timing report (bench_timing=1) ──────────────────────────────
+ * One line per stage; any write resets the counters so a benchmark run can
+ * start from a clean slate without reloading the module.
+ */
+static int timing_show(struct seq_file *m, void *v)
+{
+    struct stage_timing t[TS_COUNT];
+    int i;
+
+    spin_lock_bh(&timing_lock);
+    memcpy(t, timing, sizeof(t));
+    spin_unlock_bh(&timing_lock);
+
+    seq_printf(m, "# stage count min_ns avg_ns max_ns io_source=%d cpus=%u\n",
+               last_io_src, num_online_cpus());
+    for (i = 0; i < TS_COUNT; i++)
+        seq_printf(m, "%s %llu %llu %llu %llu\n", timing_names[i],
+                   t[i].count, t[i].count ? t[i].min_ns : 0,
+                   t[i].count ? div64_u64(t[i].total_ns, t[i].count) : 0,
+                   t[i].max_ns);
+    return 0;
+}
+
+static int timing_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, timing_show, NULL);
+}
+
+static ssize_t timing_write(struct file *file, const char __user *buf,
+                            size_t count, loff_t *ppos)
+{
+    timing_reset();
+    return count;
+}
+
+static const struct proc_ops timing_file_ops = {
+    .proc_open    = timing_open,
+    .proc_read    = seq_read,
+    .proc_write   = timing_write,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* ─── /proc lateness histogram ──────────────────────────────────────────
+ * How late each sampling tick fired, as a log2 histogram in us.  Timer
+ * lateness is a cheap proxy for how responsive the system is; it is also
+ * the tick_late metric, with late_threshold as its alert.  Any write
+ * resets the histogram.
+ */
+static int lateness_show(struct seq_file *m, void *v)
+{
+    struct sh_hist h;
+    u64 missed;
+    int i;
+
+    spin_lock_bh(&timing_lock);
+    h      = late_hist;
+    missed = late_missed;
+    spin_unlock_bh(&timing_lock);
+
+    seq_printf(m, "# ticks %llu missed %llu p50_us %llu p99_us %llu "
+               "p999_us %llu max_us %llu resolution=ns\n",
+               h.count, missed, sh_hist_quantile(&h, 500),
+               sh_hist_quantile(&h, 990), sh_hist_quantile(&h, 999), h.max);
+    seq_puts(m, "# le_us count\n");
+    for (i = 0; i < SH_HIST_BUCKETS; i++) {
+        if (!h.bucket[i])
+            continue;
+        if (i == SH_HIST_BUCKETS - 1)
+            seq_printf(m, "inf %llu\n", h.bucket[i]);
+        else
+            seq_printf(m, "%llu %llu\n", sh_hist_upper(i), h.bucket[i]);
+    }
+    return 0;
+}
+
+static int lateness_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, lateness_show, NULL);
+}
+
+static ssize_t lateness_write(struct file *file, const char __user *buf,
+                              size_t count, loff_t *ppos)
+{
+    spin_lock_bh(&timing_lock);
+    memset(&late_hist, 0, sizeof(late_hist));
+    late_missed = 0;
+    spin_unlock_bh(&timing_lock);
+    return count;
+}
+
+static const struct proc_ops lateness_file_ops = {
+    .proc_open    = lateness_open,
+    .proc_read    = seq_read,
+    .proc_write   = lateness_write,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* ─── /proc wakeup latency (COL_WAKEUP) ─────────────────────────────────
+ * One line per probed CPU: totals since enable (or the last write, which
+ * resets them) and the p99/max of the window ending at the last tick.
+ */
+static int wakeup_show(struct seq_file *m, void *v)
+{
+    int cpu;
+
+    seq_printf(m, "# cpu samples p50_us p99_us max_us last_p99_us "
+               "last_max_us running=%d\n", !!collector_on(COL_WAKEUP));
+    mutex_lock(&collector_mutex);
+    for_each_cpu(cpu, &wakeup_running) {
+        struct wakeup_cpu *wc = per_cpu_ptr(wakeup_stats, cpu);
+        struct sh_hist h;
+        u64 p99, max;
+
+        spin_lock_bh(&wc->lock);
+        h = wc->total;
+        sh_hist_merge(&h, &wc->win);
+        p99 = wc->last_p99;
+        max = wc->last_max;
+        spin_unlock_bh(&wc->lock);
+
+        seq_printf(m, "%d %llu %llu %llu %llu %llu %llu\n", cpu, h.count,
+                   sh_hist_quantile(&h, 500), sh_hist_quantile(&h, 990),
+                   h.max, p99, max);
+    }
+    mutex_unlock(&collector_mutex);
+    return 0;
+}
+
+static int wakeup_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, wakeup_show, NULL);
+}
+
+static ssize_t wakeup_write(struct file *file, const char __user *buf,
+                            size_t count, loff_t *ppos)
+{
+    int cpu;
+
+    mutex_lock(&collector_mutex);
+    for_each_cpu(cpu, &wakeup_running) {
+        struct wakeup_cpu *wc = per_cpu_ptr(wakeup_stats, cpu);
+
+        spin_lock_bh(&wc->lock);
+        memset(&wc->total, 0, sizeof(wc->total));
+        spin_unlock_bh(&wc->lock);
+    }
+    mutex_unlock(&collector_mutex);
+    return count;
+}
+
+static const struct proc_ops wakeup_file_ops = {
+    .proc_open    = wakeup_open,
+    .proc_read    = seq_read,
+    .proc_write   = wakeup_write,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* ─── /proc fragmentation report (COL_FRAG) ─────────────────────────────
+ * One line per populated zone.  *_dist columns are free pages minus the
+ * watermark: negative below min means allocations are already stalling.
+ * Works whether or not the collector is enabled; it only reads counters.
+ */
+static int frag_show(struct seq_file *m, void *v)
+{
+    unsigned long events[NR_VM_EVENT_ITEMS];
+    unsigned long nr_free[SH_NR_ORDERS];
+    unsigned int orders = READ_ONCE(frag_orders), o;
+    struct zone *zone;
+    int nid, z;
+
+    all_vm_events(events);
+    seq_printf(m, "# kswapd_runs %lu low_wmark_hit_quickly %lu "
+               "high_wmark_hit_quickly %lu alert_order %u\n",
+               events[PAGEOUTRUN], events[KSWAPD_LOW_WMARK_HIT_QUICKLY],
+               events[KSWAPD_HIGH_WMARK_HIT_QUICKLY], frag_order());
+    seq_puts(m, "# node zone free_pages min_dist low_dist high_dist");
+    for (o = 0; o < SH_NR_ORDERS; o++)
+        if (orders & BIT(o))
+            seq_printf(m, " unusable_o%u", o);
+    seq_printf(m, " nr_free[0..%u]\n", SH_NR_ORDERS - 1);
+
+    for_each_sh_zone(nid, z, zone) {
+        long free = zone_page_state(zone, NR_FREE_PAGES);
+
+        frag_zone_free(zone, nr_free);
+        seq_printf(m, "%d %s %ld %ld %ld %ld", nid, zone->name, free,
+                   free - (long)min_wmark_pages(zone),
+                   free - (long)low_wmark_pages(zone),
+                   free - (long)high_wmark_pages(zone));
+        for (o = 0; o < SH_NR_ORDERS; o++)
+            if (orders & BIT(o))
+                seq_printf(m, " %u",
+                           sh_unusable_index(nr_free, SH_NR_ORDERS, o));
+        for (o = 0; o < SH_NR_ORDERS; o++)
+            seq_printf(m, " %lu", nr_free[o]);
+        seq_putc(m, '\n');
+    }
+    return 0;
+}
+
+static int frag_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, frag_show, NULL);
+}
+
+static const struct proc_ops frag_file_ops = {
+    .proc_open    = frag_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* ─── /proc kernel memory report (COL_KMEM) ─────────────────────────────
+ * Current size and fitted growth of each class over the window.  leaking
+ * is the same test that feeds kmem_growth.
+ */
+static int kmem_show(struct seq_file *m, void *v)
+{
+    unsigned int n = kmem_window(), filled;
+    struct sh_trend t[KMEM_COUNT];
+    u64 kib[KMEM_COUNT];
+    bool leaking[KMEM_COUNT];
+    int c;
+
+    kmem_read(kib);
+    spin_lock_bh(&kmem_lock);
+    filled = kmem_filled;
+    for (c = 0; c < KMEM_COUNT; c++) {
+        sh_trend_fit(kmem_ring[c], SH_TREND_MAX, kmem_head,
+                     min(n, filled), &t[c]);
+        leaking[c] = kmem_leaking(&t[c], n);
+    }
+    spin_unlock_bh(&kmem_lock);
+
+    seq_printf(m, "# window %u samples, filled %u, running=%d\n", n,
+               min(filled, n), !!collector_on(COL_KMEM));
+    seq_puts(m, "# class now_kib growth_kib_min falls leaking\n");
+    for (c = 0; c < KMEM_COUNT; c++)
+        seq_printf(m, "%s %llu %lld %u %d\n", kmem_names[c], kib[c],
+                   kmem_per_min(t[c].slope_milli), t[c].falls, leaking[c]);
+    return 0;
+}
+
+static int kmem_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, kmem_show, NULL);
+}
+
+static const struct proc_ops kmem_file_ops = {
+    .proc_open    = kmem_open,
+    .proc_read    = seq_read,
+    .proc_lseek   = seq_lseek,
+    .proc_release = single_release,
+};
+
+/* ─── /proc binary history (sys_health_uapi.h) ──────────────────────────
+ * The file position is the next sequence number to return, so every open
+ * file is its own cursor and lseek() works in samples.  Records are copied
+ * out of the ring in batches through a bounce buffer, since copy_to_user()
+ * may fault and cannot run under history_lock.
+ */
+#define HISTORY_BATCH  64
+
+static ssize_t history_read(struct file *file, char __user *buf,
+                            size_t count, loff_t *ppos)
+{
+    size_t want = count / sizeof(struct sh_record), done = 0;
+    struct sh_record *bounce;
+    ssize_t ret = 0;
+
+    if (!want)
+        return -EINVAL;
+    if (*ppos < 0)
+        return -EINVAL;
+    bounce = kmalloc_array(HISTORY_BATCH, sizeof(*bounce), GFP_KERNEL);
+    if (!bounce)
+        return -ENOMEM;
+
+    while (done < want) {
+        u64 pos = *ppos, end, oldest;
+        size_t n = 0;
+
+        spin_lock_bh(&history_lock);
+        end = history_seq;
+        oldest = end > history_len ? end - history_len : 0;
+        if (pos < oldest) {
+            sh_record_lost(&bounce[n++], pos, oldest - pos);
+            pos = oldest;
+        }
+        while (n < min_t(size_t, want - done, HISTORY_BATCH) && pos < end)
+            history_get(pos++, &bounce[n++]);
+        spin_unlock_bh(&history_lock);
+
+        if (!n)
+            break;
+        if (copy_to_user(buf + done * sizeof(*bounce), bounce,
+                         n * sizeof(*bounce))) {
+            ret = -EFAULT;
+            break;
+        }
+        done += n;
+        *ppos = pos;
+    }
+    kfree(bounce);
+    return done ? done * sizeof(struct sh_record) : ret;
+}
+
+static loff_t history_lseek(struct file *file, loff_t offset, int whence)
+{
+    loff_t base;
+
+    switch (whence) {
+    case SEEK_SET: base = 0;                         break;
+    case SEEK_CUR: base = file->f_pos;               break;
+    case SEEK_END: base = READ_ONCE(history_seq);    break;
+    default:       return -EINVAL;
+    }
+    if (base + offset < 0)
+        return -EINVAL;
+    file->f_pos = base + offset;
+    return file->f_pos;
+}
+
+static const struct proc_ops history_file_ops = {
+    .proc_read    = history_read,
+    .proc_lseek   = history_lseek,
+};
+
+/* ─── /proc history queries ─────────────────────────────────────────────
+ * Write a query (syntax above sh_query_parse() in sys_health_core.h), then
+ * read the answer: one "start_ms count value" line per bucket.  The answer
+ * belongs to the open file, so agents sharing the file do not see each
+ * other's, and every write replaces it and rewinds.  The time column and
+ * the metric's column are copied out QUERY_CHUNK samples per hold of
+ * history_lock, so the tick never waits behind a whole ring, and the
+ * query runs unlocked on the copy.
+ */
+#define QUERY_LINE_MAX  44      /* "%llu %u %u\n" */
+#define QUERY_CHUNK     1024    /* samples copied per history_lock hold */
+
+struct query_reader {
+    struct mutex lock;
+    char        *text;          /* answer to the last query written */
+    size_t       len;
+};
+
+static int query_open(struct inode *inode, struct file *file)
+{
+    struct query_reader *r = kzalloc(sizeof(*r), GFP_KERNEL);
+
+    if (!r)
+        return -ENOMEM;
+    mutex_init(&r->lock);
+    file->private_data = r;
+    return 0;
+}
+
+/* Copies, oldest first, every sample below the history_seq seen on entry.
+ * Samples the tick overwrites while the lock is dropped are skipped.
+ * Returns how many were copied.
+ */
+static u32 query_copy(enum sh_metric metric, u64 *time, u32 *val)
+{
+    u64 seq, end, oldest;
+    u32 n = 0;
+
+    spin_lock_bh(&history_lock);
+    end = history_seq;
+    spin_unlock_bh(&history_lock);
+    seq = end > history_len ? end - history_len : 0;
+
+    while (seq < end) {
+        u32 idx, chunk;
+
+        spin_lock_bh(&history_lock);
+        oldest = history_seq > history_len ? history_seq - history_len : 0;
+        seq = max(seq, oldest);
+        if (seq < end) {
+            idx   = seq % history_len;
+            chunk = min_t(u64, end - seq,
+                          min_t(u32, QUERY_CHUNK, history_len - idx));
+            memcpy(time + n, history_time + idx, chunk * sizeof(*time));
+            memcpy(val + n, history_val[metric] + idx, chunk * sizeof(*val));
+            n   += chunk;
+            seq += chunk;
+        }
+        spin_unlock_bh(&history_lock);
+        cond_resched();
+    }
+    return n;
+}
+
+static int query_run(const struct sh_query *q, char **text, size_t *len)
+{
+    u64 from = q->from_ms;
+    struct sh_bucket *out;
+    u64 *time;
+    u32 *val;
+    u32 n, nb, i;
+    size_t size, pos = 0;
+    int ret = -ENOMEM;
+
+    if (q->last_s) {
+        u64 now = div_u64(ktime_get_real_ns(), NSEC_PER_MSEC);
+        u64 span = (u64)q->last_s * MSEC_PER_SEC;
+
+        from = now > span ? now - span : 0;
+    }
+    out  = kvmalloc_array(history_len, sizeof(*out), GFP_KERNEL);
+    time = kvmalloc_array(history_len, sizeof(*time), GFP_KERNEL);
+    val  = kvmalloc_array(history_len, sizeof(*val), GFP_KERNEL);
+    if (!out || !time || !val)
+        goto out;
+
+    n  = query_copy(q->metric, time, val);
+    nb = sh_query_run(q, from, q->to_ms, time, val, n, 0, n, out,
+                      history_len);
+
+    size = (size_t)nb * QUERY_LINE_MAX + 1;
+    *text = kvmalloc(size, GFP_KERNEL);
+    if (!*text)
+        goto out;
+    for (i = 0; i < nb; i++)
+        pos += scnprintf(*text + pos, size - pos, "%llu %u %u\n",
+                         out[i].start_ms, out[i].count, out[i].value);
+    *len = pos;
+    ret = 0;
+out:
+    kvfree(val);
+    kvfree(time);
+    kvfree(out);
+    return ret;
+}
+
+static ssize_t query_write(struct file *file, const char __user *ubuf,
+                           size_t count, loff_t *ppos)
+{
+    struct query_reader *r = file->private_data;
+    char req[SH_QUERY_MAX_LEN];
+    struct sh_query q;
+    char *text;
+    size_t len;
+    int ret;
+
+    if (count >= sizeof(req))
+        return -EINVAL;
+    if (copy_from_user(req, ubuf, count))
+        return -EFAULT;
+    ret = sh_query_parse(req, count, &q);
+    if (!ret)
+        ret = query_run(&q, &text, &len);
+    if (ret)
+        return ret;
+
+    mutex_lock(&r->lock);
+    kvfree(r->text);
+    r->text = text;
+    r->len  = len;
+    *ppos   = 0;
+    mutex_unlock(&r->lock);
+    return count;
+}
+
+static ssize_t query_read(struct file *file, char __user *ubuf,
+                          size_t count, loff_t *ppos)
+{
+    struct query_reader *r = file->private_data;
+    ssize_t ret;
+
+    mutex_lock(&r->lock);
+    ret = simple_read_from_buffer(ubuf, count, ppos, r->text, r->len);
+    mutex_unlock(&r->lock);
+    return ret;
+}
+
+static int query_release(struct inode *inode, struct file *file)
+{
+    struct query_reader *r = file->private_data;
+
+    kvfree(r->text);
+    kfree(r);
+    return 0;
+}
+
+static const struct proc_ops query_file_ops = {
+    .proc_open    = query_open,
+    .proc_read    = query_read,
+    .proc_write   = query_write,
+    .proc_release = query_release,
+};
+
+/* ─── Lifecycle ────────────────────────────────────────────────────────── */
+static int __init sys_health_init(void)
+{
+    int ret;
+
+    spin_lock_init(&snap_lock);
+    spin_lock_init(&timing_lock);
+    timing_reset();
+    alerts_init();
+
+    mutex_lock(&collector_mutex);
+    collectors_ready = true;
+    collectors_apply_locked();
+    mutex_unlock(&collector_mutex);
+
+    printk(KERN_INFO TAG
+           "SCIA 360: Module v1.5 loaded successfully. "
+           "Team Members: Kamden Morgan, Alicia Mansaray, Alex Rodriguez\n");
+
+    ret = history_init();
+    if (ret)
+        goto err_history;
+
+    ret = snap_replicas_init();
+    if (ret)
+        goto err_replicas;
+
+    ret = numa_workers_init();
+    if (ret)
+        goto err_workers;
+
+    ret = alerts_kobj_init();
+    if (ret)
+        goto err_workers;
+
+    ret = metrics_sysfs_init();
+    if (ret)
+        goto err_kobj;
+
+    ret = -ENOMEM;
+    proc_entry = proc_create("sys_health", 0444, NULL, &proc_file_ops);
+    if (!proc_entry)
+        goto err_metrics;
+
+    timing_entry = proc_create("sys_health_timing", 0644, NULL,
+                               &timing_file_ops);
+    if (!timing_entry)
+        goto err_proc;
+
+    alerts_entry = proc_create("sys_health_alerts", 0444, NULL,
+                               &journal_file_ops);
+    if (!alerts_entry)
+        goto err_timing;
+
+    lateness_entry = proc_create("sys_health_lateness", 0644, NULL,
+                                 &lateness_file_ops);
+    if (!lateness_entry)
+        goto err_alerts;
+
+    wakeup_entry = proc_create("sys_health_wakeup", 0644, NULL,
+                               &wakeup_file_ops);
+    if (!wakeup_entry)
+        goto err_lateness;
+
+    frag_entry = proc_create("sys_health_frag", 0444, NULL, &frag_file_ops);
+    if (!frag_entry)
+        goto err_wakeup;
+
+    kmem_entry = proc_create("sys_health_kmem", 0444, NULL, &kmem_file_ops);
+    if (!kmem_entry)
+        goto err_frag;
+
+    history_entry = proc_create("sys_health_history", 0444, NULL,
+                                &history_file_ops);
+    if (!history_entry)
+        goto err_kmem;
+
+    /* Root only: each query allocates and copies up to the whole history. */
+    query_entry = proc_create("sys_health_query", 0644, NULL,
+                              &query_file_ops);
+    if (!query_entry)
+        goto err_history_proc;
+
+    if (mmap_pages) {
+        ring_entry = proc_create("sys_health_ring", 0444, NULL,
+                                 &ring_file_ops);
+        if (!ring_entry)
+            goto err_query;
+    }
+
+    poll_init();
+    if (align_wallclock) {
+        align_init();
+        align_start();
+    } else {
+        poll_start();
+    }
+
+    atomic_notifier_chain_register(&panic_notifier_list, &history_panic_nb);
+
+    spin_lock_bh(&alert_lock);
+    alerts_live = true;
+    spin_unlock_bh(&alert_lock);
+    return 0;
+
+err_query:
+    proc_remove(query_entry);
+err_history_proc:
+    proc_remove(history_entry);
+err_kmem:
+    proc_remove(kmem_entry);
+err_frag:
+    proc_remove(frag_entry);
+err_wakeup:
+    proc_remove(wakeup_entry);
+err_lateness:
+    proc_remove(lateness_entry);
+err_alerts:
+    journal_shutdown();
+    proc_remove(alerts_entry);
+err_timing:
+    proc_remove(timing_entry);
+err_proc:
+    proc_remove(proc_entry);
+err_metrics:
+    metrics_sysfs_exit();
+err_kobj:
+    cancel_work_sync(&alert_work);  /* readers above may have queued it */
+    alerts_kobj_exit();
+err_workers:
+    numa_workers_exit();
+err_replicas:
+    snap_replicas_exit();
+    history_exit();
+err_history:
+    wakeup_exit();
+    return ret;
+}
+
 static void __exit sys_health_exit(void)
 {
-    del_timer_sync(&poll_timer);
+    atomic_notifier_chain_unregister(&panic_notifier_list, &history_panic_nb);
+    spin_lock_bh(&alert_lock);
+    alerts_live = false;            /* parameter writes stop re‑evaluating */
+    spin_unlock_bh(&alert_lock);
+    journal_shutdown();             /* wakes blocked journal readers */
+    if (alerts_entry)
+        proc_remove(alerts_entry);
+    if (lateness_entry)
+        proc_remove(lateness_entry);
+    if (wakeup_entry)
+        proc_remove(wakeup_entry);
+    if (frag_entry)
+        proc_remove(frag_entry);
+    if (kmem_entry)
+        proc_remove(kmem_entry);
+    if (history_entry)
+        proc_remove(history_entry);
+    if (ring_entry)
+        proc_remove(ring_entry);
+    if (query_entry)
+        proc_remove(query_entry);
+    if (timing_entry)
+        proc_remove(timing_entry);
     if (proc_entry)
         proc_remove(proc_entry);
+    metrics_sysfs_exit();           /* no reader can reach collect_now() */
+    if (align_wallclock)            /* watchdog won't restart it now */
+        hrtimer_cancel(&align_timer);
+    hrtimer_cancel(&poll_timer);
+    del_timer_sync(&align_watchdog);
+    cancel_work_sync(&alert_work);  /* no producers left */
+    wakeup_exit();
+    numa_workers_exit();
+    alerts_kobj_exit();
+    snap_replicas_exit();           /* no readers left after proc_remove */
+    history_exit();
     printk(KERN_INFO TAG "SCIA 360: Module unloaded. Goodbye!\n");
 }
 
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*───────────────────────────────────────────────────────────────────────────
+ * sys_health_uapi.h – binary interfaces of sys_health_monitor.
+ *
+ * Shared by the module, sys_health_core.h and userspace readers; only
+ * fixed‑width types, so it can be copied into an agent as is.
+ *
+ * /proc/sys_health_history
+ *   The file position is a sample sequence number, not a byte offset.
+ *   read() returns as many whole struct sh_record as fit in the buffer,
+ *   oldest first, starting at the position, and advances it; 0 means the
+ *   reader has caught up.  Buffers smaller than one record get -EINVAL.
+ *   If the ring has overwritten records since the position, the first
+ *   record returned is a gap marker (SH_REC_LOST) and reading resumes at
+ *   the oldest record still held.
+ *   lseek(fd, seq, SEEK_SET) jumps to a sequence number, SEEK_CUR moves
+ *   relative to the position and SEEK_END relative to the next sample to
+ *   be taken: lseek(fd, -100, SEEK_END) replays the last 100 samples.
+ *
+ * /proc/sys_health_ring (mmap_pages > 0)
+ *   A read‑only mapping of one struct sh_ring_page followed, at
+ *   data_offset, by nr_records struct sh_record slots; sequence number s
+ *   lives in slot s % nr_records.  The kernel fills a slot and then
+ *   publishes head with release semantics.  A reader keeps its own cursor,
+ *   loads head with acquire semantics, copies the records in between,
+ *   and reloads head: a copied record s is valid only if
+ *   s + nr_records > head (the slot of head itself may be mid‑write).
+ *   userspace/sh_ring.h implements this.  The mapping never changes the
+ *   ring, so any number of readers can follow it at their own pace.
+ *───────────────────────────────────────────────────────────────────────────*/
+#ifndef SYS_HEALTH_UAPI_H
+#define SYS_HEALTH_UAPI_H
+
+#include <linux/types.h>
+
+#define SH_RECORD_VERSION  2
+#define SH_REC_VALUES      16       /* room for future metrics */
+
+/* flags */
+#define SH_REC_LOST        0x1      /* gap marker, see below */
+
+/* One sample.  value[] is indexed by metric (the order of the metrics/
+ * directories in sysfs and of "SHM1 M" lines); unused slots are 0.
+ * severity packs each metric's level (0 info, 1 warning, 2 critical) into
+ * 2 bits, metric 0 in the low bits.  A gap marker has SH_REC_LOST set,
+ * seq = first missing sequence number, value[0]/value[1] = low/high 32
+ * bits of the number of records lost, and nothing else.
+ */
+struct sh_record {
+    __u64 seq;
+    __u64 wall_ms;              /* CLOCK_REALTIME, ms since the epoch */
+    __u32 value[SH_REC_VALUES];
+    __u32 severity;
+    __u32 flags;
+};
+
+/* Control page at offset 0 of the /proc/sys_health_ring mapping. */
+struct sh_ring_page {
+    __u32 version;              /* SH_RECORD_VERSION */
+    __u32 record_size;          /* sizeof(struct sh_record) */
+    __u32 nr_records;           /* slots in the data area */
+    __u32 __pad;
+    __u64 data_offset;          /* bytes from the start of the mapping */
+    __u64 data_size;            /* bytes, nr_records * record_size */
+    __u64 __reserved[5];
+    /* own cache line, written every tick */
+    __u64 head;                 /* sequence number of the next record */
+    __u64 tail;                 /* oldest sequence number still held */
+};
+
+#endif /* SYS_HEALTH_UAPI_H */
@@ -0,0 +1,168 @@
+/*
+ * bench_core.c – microbenchmarks for sys_health_core.h.
+ *
+ * Build and run:  make -C userspace bench && userspace/bench_core [filter]
+ */
+#include "../sys_health_core.h"
+#include "microbench.h"
+
+static volatile uint64_t seed = 0x9e3779b97f4a7c15ull;
+
+static inline uint64_t next_rand(uint64_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+    return *x;
+}
+
+BENCH(pages_to_mib)
+{
+    uint64_t x = seed, acc = 0;
+
+    while (iters--)
+        acc += sh_pages_to_mib(next_rand(&x) >> 20, 12);
+    bench_keep(acc);
+}
+
+BENCH(load_percent)
+{
+    uint64_t x = seed, acc = 0;
+
+    while (iters--)
+        acc += sh_load_percent(next_rand(&x) & 0xffffff, 11,
+                               (unsigned int)(x & 255) + 1);
+    bench_keep(acc);
+}
+
+BENCH(rate_per_sec)
+{
+    uint64_t x = seed, acc = 0;
+
+    while (iters--)
+        acc += sh_rate_per_sec(next_rand(&x) >> 24, 5000000000ull + (x & 0xffff));
+    bench_keep(acc);
+}
+
+BENCH(eval_alerts)
+{
+    const int thresholds[SH_METRIC_COUNT] = { 100, 80, 5000 };
+    struct sys_snapshot s = { 0 };
+    uint64_t x = seed, acc = 0;
+
+    while (iters--) {
+        next_rand(&x);
+        s.free_mem_mib = (u32)x & 1023;
+        s.load_pct     = (u32)(x >> 10) & 127;
+        s.io_rate_sps  = (u32)(x >> 17) & 8191;
+        acc += sh_eval_alerts(&s, thresholds);
+    }
+    bench_keep(acc);
+}
+
+BENCH(format_snapshot)
+{
+    struct sys_snapshot s = {
+        .ts_ms = 123456789, .free_mem_mib = 2048, .total_mem_mib = 16384,
+        .load_pct = 42, .io_rate_sps = 31337,
+    };
+    char buf[256];
+    uint64_t acc = 0;
+
+    while (iters--) {
+        s.ts_ms++;
+        acc += sh_format_snapshot(buf, sizeof(buf), &s);
+    }
+    bench_keep(acc);
+}
+
+/* A day at poll_ms=5000 is 17280 samples; 65536 is the largest history. */
+#define Q_SAMPLES  65536
+
+static u64 q_time[Q_SAMPLES], q_tcopy[Q_SAMPLES];
+static u32 q_col[Q_SAMPLES], q_val[Q_SAMPLES];
+static struct sh_record q_rec[Q_SAMPLES];
+static struct sh_bucket q_out[Q_SAMPLES];
+
+static void query_setup(void)
+{
+    uint64_t x = seed;
+    u32 i;
+
+    for (i = 0; i < Q_SAMPLES; i++) {
+        q_time[i] = 1700000000000ull + i * 5000ull;
+        q_col[i]  = (u32)next_rand(&x) & 0xffff;
+        q_rec[i].wall_ms = q_time[i];
+        q_rec[i].value[SH_METRIC_IO_RATE] = q_col[i];
+    }
+}
+
+static void query_bench(uint64_t iters, const char *text)
+{
+    struct sh_query q;
+    uint64_t acc = 0;
+
+    if (!q_time[0])
+        query_setup();
+    sh_query_parse(text, strlen(text), &q);
+    while (iters--) {
+        if (q.agg == SH_AGG_PCT) {
+            /* Copied out first, as the module does, since they reorder. */
+            memcpy(q_tcopy, q_time, sizeof(q_tcopy));
+            memcpy(q_val, q_col, sizeof(q_val));
+            acc += sh_query_run(&q, 0, U64_MAX, q_tcopy, q_val, Q_SAMPLES,
+                                0, Q_SAMPLES, q_out, Q_SAMPLES);
+        } else {
+            acc += sh_query_run(&q, 0, U64_MAX, q_time, q_col, Q_SAMPLES,
+                                Q_SAMPLES / 2, Q_SAMPLES, q_out, Q_SAMPLES);
+        }
+    }
+    bench_keep(acc);
+}
+
+BENCH(query_max_hourly)
+{
+    query_bench(iters, "metric=io_rate agg=max bucket=3600");
+}
+
+BENCH(query_p99_hourly)
+{
+    query_bench(iters, "metric=io_rate agg=p99 bucket=3600");
+}
+
+/* A plain max over the same samples kept as 88‑byte records: the least a
+ * row layout has to touch.
+ */
+BENCH(query_max_rows)
+{
+    uint64_t acc = 0;
+    u32 i;
+
+    if (!q_time[0])
+        query_setup();
+    while (iters--) {
+        u32 max = 0;
+
+        for (i = 0; i < Q_SAMPLES; i++)
+            if (q_rec[i].wall_ms >= q_time[0])
+                max = max_t(u32, max, q_rec[i].value[SH_METRIC_IO_RATE]);
+        acc += max;
+    }
+    bench_keep(acc);
+}
+
+static const struct bench_case cases[] = {
+    BENCH_ENTRY(pages_to_mib),
+    BENCH_ENTRY(load_percent),
+    BENCH_ENTRY(rate_per_sec),
+    BENCH_ENTRY(eval_alerts),
+    BENCH_ENTRY(format_snapshot),
+    BENCH_ENTRY(query_max_hourly),
+    BENCH_ENTRY(query_p99_hourly),
+    BENCH_ENTRY(query_max_rows),
+};
+
+int main(int argc, char **argv)
+{
+    return bench_run_all(cases, ARRAY_SIZE(cases), argc, argv);
+}
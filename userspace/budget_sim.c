@@ -0,0 +1,159 @@
+/*
+ * budget_sim.c – worst‑case tick duration of a budgeted collector walk.
+ *
+ * Simulates a collector over N items (default 10000) with a fixed per‑item
+ * cost, driven tick by tick through the sh_budget/sh_cursor helpers as
+ * read_disk_sectors() does in the module: each tick restarts at the head,
+ * passes over the items already summed at a smaller per‑item cost, charges
+ * them with sh_budget_charge() and carries on from the cursor.  Reports the
+ * worst and mean tick duration, ticks per full pass, the longest skip, and
+ * checks that every completed pass sums to the right total.  Exits non‑zero if any tick processed more items
+ * than fit in the budget plus one SH_BUDGET_STRIDE.  That bound is checked
+ * on item counts rather than wall time because a userspace run can be
+ * preempted mid‑tick; the p99/worst durations are printed for reference.
+ *
+ *   userspace/budget_sim [-n items] [-b budget_us] [-c item_cost_ns]
+ *                        [-s skip_cost_ns] [-p passes]
+ */
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../sys_health_core.h"
+
+static u64 now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void burn(u64 ns)
+{
+    u64 end = now_ns() + ns;
+
+    while (now_ns() < end)
+        ;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* One tick: the equivalent of read_disk_sectors() over an array. */
+static bool walk(struct sh_cursor *c, struct sh_budget *b, const u64 *items,
+                 u64 n, u64 cost_ns, u64 skip_ns, u64 *total)
+{
+    u64 idx;
+
+    burn(c->pos * skip_ns);         /* back from the head to the cursor */
+    sh_budget_charge(b, c->pos);
+    for (idx = c->pos; idx < n; idx++) {
+        burn(cost_ns);
+        c->acc += items[idx];
+        c->pos++;
+        if (sh_budget_spent(b, now_ns))
+            return false;
+    }
+    *total = sh_cursor_finish(c);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    u64 n = 10000, budget_us = 500, cost_ns = 200, skip_ns = 5, passes = 20;
+    u64 expect = 0, sum = 0, ticks = 0, done = 0, max_items = 0, i;
+    u64 max_skip = 0;
+    struct sh_cursor cur = { 0 };
+    u64 *items, *durations, limit, cap;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:b:c:s:p:")) != -1) {
+        switch (opt) {
+        case 'n': n         = strtoull(optarg, NULL, 0); break;
+        case 'b': budget_us = strtoull(optarg, NULL, 0); break;
+        case 'c': cost_ns   = strtoull(optarg, NULL, 0); break;
+        case 's': skip_ns   = strtoull(optarg, NULL, 0); break;
+        case 'p': passes    = strtoull(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-n items] [-b budget_us] "
+                    "[-c item_cost_ns] [-s skip_cost_ns] [-p passes]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    items = malloc(n * sizeof(*items));
+    /* Worst case one item per tick, once a skip uses up the budget. */
+    cap = passes * (n + 1);
+    durations = malloc(cap * sizeof(*durations));
+    if (!items || !durations)
+        return 1;
+    for (i = 0; i < n; i++) {
+        items[i] = i * 7 + 1;
+        expect  += items[i];
+    }
+
+    while (done < passes && ticks < cap) {
+        struct sh_budget b;
+        u64 t0 = now_ns(), start = cur.pos, total, dt, visited;
+
+        sh_budget_start(&b, t0, budget_us * NSEC_PER_USEC);
+        max_skip = start > max_skip ? start : max_skip;
+        if (walk(&cur, &b, items, n, cost_ns, skip_ns, &total)) {
+            if (total != expect) {
+                fprintf(stderr, "pass %llu: sum %llu != %llu\n",
+                        (unsigned long long)done,
+                        (unsigned long long)total,
+                        (unsigned long long)expect);
+                return 2;
+            }
+            done++;
+            visited = n - start;
+        } else {
+            visited = cur.pos - start;
+        }
+        dt = now_ns() - t0;
+        max_items = visited > max_items ? visited : max_items;
+        durations[ticks++] = dt;
+        sum += dt;
+    }
+    qsort(durations, ticks, sizeof(*durations), cmp_u64);
+
+    /* Items that fit in the budget, rounded up to the clock‑check stride. */
+    limit = budget_us && cost_ns ?
+            (budget_us * NSEC_PER_USEC / cost_ns / SH_BUDGET_STRIDE + 1) *
+            SH_BUDGET_STRIDE : n;
+    printf("items=%llu budget=%llu us item_cost=%llu ns skip_cost=%llu ns\n",
+           (unsigned long long)n, (unsigned long long)budget_us,
+           (unsigned long long)cost_ns, (unsigned long long)skip_ns);
+    printf("ticks=%llu passes=%llu ticks/pass=%.1f\n",
+           (unsigned long long)ticks, (unsigned long long)done,
+           (double)ticks / done);
+    printf("tick mean=%.1f us p99=%.1f us worst=%.1f us "
+           "(unbudgeted pass ~%.1f us)\n",
+           sum / 1e3 / ticks, durations[ticks * 99 / 100] / 1e3,
+           durations[ticks - 1] / 1e3, n * cost_ns / 1e3);
+    printf("items/tick max=%llu limit=%llu, longest skip %llu items "
+           "(~%.1f us)\n", (unsigned long long)max_items,
+           (unsigned long long)limit, (unsigned long long)max_skip,
+           max_skip * skip_ns / 1e3);
+
+    free(durations);
+    free(items);
+    if (done < passes) {
+        fprintf(stderr, "only %llu of %llu passes completed\n",
+                (unsigned long long)done, (unsigned long long)passes);
+        return 4;
+    }
+    if (max_items > limit) {
+        fprintf(stderr, "a tick visited %llu items, budget allows %llu\n",
+                (unsigned long long)max_items, (unsigned long long)limit);
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * fuzz_format.c – libFuzzer target for the snapshot math and formatter.
+ *
+ * Feeds arbitrary snapshot values, thresholds and buffer sizes through
+ * sh_eval_alerts(), sh_stale_mask(), sh_format_snapshot() and
+ * sh_format_event() and checks the scnprintf contract (length < size,
+ * NUL‑terminated, no write past the end).  Buddy free lists for the
+ * fragmentation helpers come from the input as well.  Journal records are
+ * built from the same bytes, enum fields included, so out‑of‑range
+ * metric/severity/state values are covered.
+ */
+#include <assert.h>
+#include <stdlib.h>
+
+#include "../sys_health_core.h"
+
+static void check_format(int n, const char *buf, size_t len)
+{
+    assert(n >= 0);
+    if (len) {
+        assert((size_t)n < len);
+        assert(buf[n] == '\0');
+    } else {
+        assert(n == 0);
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    struct sys_snapshot s;
+    struct sh_alert_event e;
+    int thresholds[SH_METRIC_COUNT];
+    size_t len;
+    char *buf;
+    int n;
+
+    if (size < sizeof(s) + sizeof(thresholds) + 2)
+        return 0;
+    memcpy(&s, data, sizeof(s));
+    memcpy(thresholds, data + sizeof(s), sizeof(thresholds));
+    len = ((size_t)data[sizeof(s) + sizeof(thresholds)] << 8 |
+           data[sizeof(s) + sizeof(thresholds) + 1]) % 512;
+
+    assert(sh_eval_alerts(&s, thresholds) < (1U << SH_METRIC_COUNT));
+
+    {
+        struct sys_snapshot t = s;
+        u64 since = s.wall_ms;
+        u32 stale = sh_stale_mask(&s, since);
+        int i;
+
+        assert(stale < (1U << SH_METRIC_COUNT));
+        for (i = 0; i < SH_METRIC_COUNT; i++) {
+            t.fresh_ms[i] = since;          /* taken this tick */
+            assert(!(sh_stale_mask(&t, since) & (1U << i)));
+            t.fresh_ms[i] = 0;              /* collector off */
+            assert(!(sh_stale_mask(&t, since) & (1U << i)));
+            t.fresh_ms[i] = (u32)since - 1; /* skipped: on‑demand Io_rate */
+            assert(!t.fresh_ms[i] || (sh_stale_mask(&t, since) & (1U << i)));
+            t.fresh_ms[i] = s.fresh_ms[i];
+        }
+        assert(sh_stale_mask(&t, since) == stale);
+    }
+    (void)sh_rate_per_sec(((u64)s.load_pct << 32) | s.io_rate_sps, s.ts_ms);
+    (void)sh_load_percent(s.free_mem_mib, s.total_mem_mib & 31,
+                          s.load_pct);
+    (void)sh_pages_to_mib(s.ts_ms, s.io_rate_sps & 31);
+
+    {
+        struct sh_hist h = { 0 };
+        u64 q;
+
+        sh_hist_add(&h, s.ts_ms);
+        sh_hist_add(&h, s.fresh_ms[0]);
+        sh_hist_add(&h, s.late_us);
+        q = sh_hist_quantile(&h, s.load_pct % 1001);
+        assert(q <= h.max);
+        assert(sh_hist_quantile(&h, 1000) == h.max);
+        assert(h.count == 3);
+    }
+
+    {
+        unsigned long nr_free[11] = { 0 };
+        unsigned int i, order = s.load_pct % 12, idx;
+
+        for (i = 0; i < 11 && i < size; i++)
+            nr_free[i] = data[i] * (1UL + s.free_mem_mib % 4096);
+        idx = sh_unusable_index(nr_free, 11, order);
+        if (sh_highorder_blocks(nr_free, 11, order))
+            assert(idx < 1000);
+        else
+            assert(idx == 1000);
+    }
+
+    {
+        u64 ring[SH_TREND_MAX];
+        unsigned int i, len = 2 + s.load_pct % (SH_TREND_MAX - 1);
+        unsigned int head = s.io_rate_sps % len, n = s.ts_ms % (len + 1);
+        u64 step = s.free_mem_mib & 0xffff;
+        struct sh_trend t;
+
+        /* A straight line fits exactly, whatever the ring rotation. */
+        for (i = 0; i < len; i++)
+            ring[(head + i) % len] = s.total_mem_mib + step * i;
+        sh_trend_fit(ring, len, head, n, &t);
+        assert(n < 2 || t.slope_milli == (s64)step * 1000);
+        assert(t.falls == 0);
+        assert(sh_tte_minutes(s.total_mem_mib, t.slope_milli, s.ts_ms) ==
+               SH_TTE_NEVER);
+        assert(sh_tte_minutes(s.total_mem_mib, -1 - (s64)step, s.ts_ms) <
+               SH_TTE_NEVER);
+    }
+
+    /* Exact‑size heap buffer so ASan catches any overrun. */
+    buf = malloc(len ? len : 1);
+    n = sh_format_snapshot(buf, len, &s);
+    check_format(n, buf, len);
+
+    memcpy(&e, data, sizeof(e));        /* sizeof(e) < sizeof(s) */
+    (void)sh_alert_severity(e.metric % SH_METRIC_COUNT, e.value, e.threshold);
+    n = sh_format_event(buf, len, &e);
+    check_format(n, buf, len);
+    if (len >= SH_EVENT_MAX_LEN && e.metric < SH_METRIC_COUNT &&
+        e.severity < SH_SEV_COUNT && e.state < SH_ALERT_STATE_COUNT)
+        assert(buf[n - 1] == '\n');       /* SH_EVENT_MAX_LEN suffices */
+    free(buf);
+    return 0;
+}
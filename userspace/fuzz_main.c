@@ -0,0 +1,121 @@
+/*
+ * fuzz_main.c – standalone driver for the fuzz targets when libFuzzer is
+ * not available (e.g. gcc builds).  Runs LLVMFuzzerTestOneInput() on each
+ * file named on the command line, then on N more inputs with "-runs=N".
+ * Without files those are pseudo‑random; with files (a seed corpus such as
+ * corpus/fuzz_query/) most are seeds with a few bytes overwritten,
+ * inserted or deleted, so targets whose input must parse get past the
+ * parser, and the rest stay random.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#define MAX_SEEDS  64
+#define MAX_INPUT  4096
+
+struct seed {
+    uint8_t *data;
+    size_t   size;
+};
+
+static struct seed seeds[MAX_SEEDS];
+static int nr_seeds;
+static uint64_t x = 0x2545f4914f6cdd1dull;
+
+static uint64_t rnd(void)
+{
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return x;
+}
+
+static int run_file(const char *path)
+{
+    static uint8_t buf[MAX_INPUT];
+    FILE *f = fopen(path, "rb");
+    size_t n;
+
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(buf, n);
+    if (nr_seeds < MAX_SEEDS) {
+        seeds[nr_seeds].data = malloc(n ? n : 1);
+        if (seeds[nr_seeds].data) {
+            memcpy(seeds[nr_seeds].data, buf, n);
+            seeds[nr_seeds++].size = n;
+        }
+    }
+    return 0;
+}
+
+/* Bytes that keep text inputs close to what a parser accepts. */
+static const char dict[] = "0123456789 =.pabcdefghilmnorstuwx\n";
+
+static size_t mutate(uint8_t *buf, size_t cap)
+{
+    const struct seed *s = &seeds[rnd() % nr_seeds];
+    size_t n = s->size, pos;
+    int i, edits = 1 + rnd() % 4;
+
+    memcpy(buf, s->data, n);
+    for (i = 0; i < edits; i++) {
+        pos = n ? rnd() % n : 0;
+        switch (rnd() % 4) {
+        case 0:                         /* overwrite, any byte */
+            if (n)
+                buf[pos] = (uint8_t)rnd();
+            break;
+        case 1:                         /* overwrite, text byte */
+            if (n)
+                buf[pos] = dict[rnd() % (sizeof(dict) - 1)];
+            break;
+        case 2:                         /* insert */
+            if (n < cap) {
+                memmove(buf + pos + 1, buf + pos, n - pos);
+                buf[pos] = dict[rnd() % (sizeof(dict) - 1)];
+                n++;
+            }
+            break;
+        default:                        /* delete */
+            if (n) {
+                memmove(buf + pos, buf + pos + 1, n - pos - 1);
+                n--;
+            }
+        }
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    long runs = 0;
+    int i, rc = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (!strncmp(argv[i], "-runs=", 6))
+            runs = atol(argv[i] + 6);
+        else
+            rc |= run_file(argv[i]);
+    }
+    while (runs-- > 0) {
+        static uint8_t buf[MAX_INPUT];
+        size_t n, j;
+
+        if (nr_seeds && rnd() % 8) {
+            n = mutate(buf, sizeof(buf));
+        } else {
+            n = rnd() % 256;
+            for (j = 0; j < n; j++)
+                buf[j] = (uint8_t)rnd();
+        }
+        LLVMFuzzerTestOneInput(buf, n);
+    }
+    return rc;
+}
@@ -0,0 +1,152 @@
+/*
+ * fuzz_query.c – libFuzzer target for the history query parser and engine.
+ *
+ * The first bytes (up to a NUL or SH_QUERY_MAX_LEN) are parsed as a query.
+ * An accepted query must be in range and survive a round trip through its
+ * canonical text.  It is then run over sample columns built from the rest
+ * of the input, with wall‑clock steps back included and, except for
+ * percentiles, wrapped around the end of the ring; every bucket is checked
+ * against a brute‑force recomputation over the samples it claims.  Seeds
+ * in corpus/fuzz_query/ are a valid query, a NUL and sample bytes; random
+ * bytes alone almost never parse.
+ */
+#include <assert.h>
+#include <stdlib.h>
+
+#include "../sys_health_core.h"
+
+#define MAX_SAMPLES  512
+
+static const char *const agg_names[] = { "min", "max", "avg", "count" };
+
+static int cmp_u32(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static int canonical(char *buf, size_t len, const struct sh_query *q)
+{
+    int n = scnprintf(buf, len, "metric=%s bucket=%u",
+                      sh_metrics[q->metric].name, q->bucket_s);
+
+    if (q->agg == SH_AGG_PCT)
+        n += scnprintf(buf + n, len - n, " agg=p%u.%u", q->permille / 10,
+                       q->permille % 10);
+    else
+        n += scnprintf(buf + n, len - n, " agg=%s", agg_names[q->agg]);
+    if (q->last_s)
+        n += scnprintf(buf + n, len - n, " last=%u", q->last_s);
+    else
+        n += scnprintf(buf + n, len - n, " from=%llu",
+                       (unsigned long long)q->from_ms);
+    n += scnprintf(buf + n, len - n, " to=%llu\n",
+                   (unsigned long long)q->to_ms);
+    return n;
+}
+
+static void check_run(const struct sh_query *q, const uint8_t *data,
+                      size_t size)
+{
+    static u64 time[MAX_SAMPLES], rtime[MAX_SAMPLES];
+    static u32 rval[MAX_SAMPLES], orig[MAX_SAMPLES], ref[MAX_SAMPLES];
+    static struct sh_bucket out[MAX_SAMPLES];
+    u64 t = 1700000000000ULL, from = q->from_ms, to = q->to_ms;
+    u64 width = (u64)q->bucket_s * MSEC_PER_SEC;
+    u32 n = 0, nb, b, i = 0, max_out, len, first = 0;
+
+    /* 3 bytes per sample: time step (high bit = step back), value. */
+    for (; n < MAX_SAMPLES && size >= 3; n++, data += 3, size -= 3) {
+        u64 step = (data[0] & 0x7f) * 250ULL;
+
+        t = data[0] & 0x80 ? t - step : t + step;
+        time[n] = t;
+        orig[n] = (u32)data[1] << 8 | data[2];
+    }
+    len = n + (q->bucket_s % (MAX_SAMPLES - n + 1));
+    if (q->agg != SH_AGG_PCT && len)
+        first = (q->last_s + q->metric) % len;
+    for (i = 0; i < n; i++) {
+        rtime[(first + i) % len] = time[i];
+        rval[(first + i) % len]  = orig[i];
+    }
+    i = 0;
+    if (q->last_s)
+        from = t > (u64)q->last_s * MSEC_PER_SEC ?
+               t - (u64)q->last_s * MSEC_PER_SEC : 0;
+    max_out = 1 + (q->permille % MAX_SAMPLES);
+
+    nb = sh_query_run(q, from, to, rtime, rval, len, first, n, out,
+                      max_out);
+    assert(nb <= max_out);
+
+    for (b = 0; b < nb; b++) {
+        u32 c = 0, mn = U32_MAX, mx = 0, expect;
+        u64 sum = 0, key = 0;
+
+        assert(out[b].count > 0);
+        while (i < n && (time[i] < from || time[i] > to))
+            i++;
+        for (; c < out[b].count; c++, i++) {
+            assert(i < n && time[i] >= from && time[i] <= to);
+            if (width) {
+                u64 k = (time[i] - from) / width;
+
+                if (!c) {
+                    key = k;
+                    assert(out[b].start_ms == from + k * width);
+                }
+                assert(k == key);
+            } else if (!c) {
+                assert(out[b].start_ms == time[i]);
+            }
+            ref[c] = orig[i];
+            mn = ref[c] < mn ? ref[c] : mn;
+            mx = ref[c] > mx ? ref[c] : mx;
+            sum += ref[c];
+        }
+        qsort(ref, c, sizeof(ref[0]), cmp_u32);
+        switch (q->agg) {
+        case SH_AGG_MIN:   expect = mn;                 break;
+        case SH_AGG_MAX:   expect = mx;                 break;
+        case SH_AGG_COUNT: expect = c;                  break;
+        case SH_AGG_PCT:
+            expect = ref[(u64)(c - 1) * q->permille / 1000];
+            break;
+        default:           expect = (u32)(sum / c);     break;
+        }
+        assert(out[b].value == expect);
+        assert(mn <= expect || q->agg == SH_AGG_COUNT);
+    }
+    /* Unless the output filled up, nothing in range was left out. */
+    if (nb < max_out)
+        for (; i < n; i++)
+            assert(time[i] < from || time[i] > to);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    char text[SH_QUERY_MAX_LEN * 2];
+    struct sh_query q, q2;
+    size_t len = 0;
+    int n;
+
+    while (len < size && len < SH_QUERY_MAX_LEN && data[len])
+        len++;
+    if (sh_query_parse((const char *)data, len, &q))
+        return 0;
+
+    assert(q.metric < SH_METRIC_COUNT);
+    assert(q.agg <= SH_AGG_PCT);
+    assert(q.permille <= 1000);
+    assert(q.from_ms <= q.to_ms);
+    assert(!(q.last_s && q.from_ms));
+
+    n = canonical(text, sizeof(text), &q);
+    assert(!sh_query_parse(text, n, &q2));
+    assert(!memcmp(&q, &q2, sizeof(q)));
+
+    check_run(&q, data + len, size - len);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * kshim.h – just enough of the kernel's types and helpers for
+ * sys_health_core.h to build as ordinary userspace C.
+ */
+#ifndef SH_KSHIM_H
+#define SH_KSHIM_H
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+#ifndef U32_MAX
+#  define U32_MAX        ((u32)~0U)
+#endif
+#ifndef U64_MAX
+#  define U64_MAX        ((u64)~0ULL)
+#endif
+#ifndef S64_MAX
+#  define S64_MAX        ((s64)(U64_MAX >> 1))
+#endif
+#define MSEC_PER_SEC     1000L
+#define USEC_PER_SEC     1000000L
+#define NSEC_PER_USEC    1000L
+#define NSEC_PER_MSEC    1000000L
+#define NSEC_PER_SEC     1000000000L
+
+#define min_t(type, a, b) ((type)(a) < (type)(b) ? (type)(a) : (type)(b))
+#define max_t(type, a, b) ((type)(a) > (type)(b) ? (type)(a) : (type)(b))
+#define clamp_t(type, v, lo, hi) min_t(type, max_t(type, v, lo), hi)
+#define ARRAY_SIZE(a)     (sizeof(a) / sizeof((a)[0]))
+#define READ_ONCE(x)      (*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v)  (*(volatile __typeof__(x) *)&(x) = (v))
+#define likely(x)         __builtin_expect(!!(x), 1)
+#define unlikely(x)       __builtin_expect(!!(x), 0)
+
+static inline u64 div_u64(u64 dividend, u32 divisor)
+{
+    return dividend / divisor;
+}
+
+static inline u64 div64_u64(u64 dividend, u64 divisor)
+{
+    return dividend / divisor;
+}
+
+static inline s64 div64_s64(s64 dividend, s64 divisor)
+{
+    return dividend / divisor;
+}
+
+/* 1‑based index of the most significant set bit, 0 for 0. */
+static inline int fls64(u64 x)
+{
+    return x ? 64 - __builtin_clzll(x) : 0;
+}
+
+/* Kernel semantics: returns the number of characters actually written. */
+static inline int scnprintf(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    int n;
+
+    if (!size)
+        return 0;
+    va_start(args, fmt);
+    n = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    if (n < 0)
+        return 0;
+    return (size_t)n >= size ? (int)(size - 1) : n;
+}
+
+#endif /* SH_KSHIM_H */
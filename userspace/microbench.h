@@ -0,0 +1,73 @@
+/*
+ * microbench.h – a minimal Google‑Benchmark‑style harness in plain C.
+ *
+ * Each BENCH(name) body receives `iters` and must run the operation that
+ * many times.  The runner grows `iters` until one run takes at least
+ * min_time_ns, then prints ns/op for that run.  Use bench_keep() on results
+ * so the optimiser cannot drop the work.  A name filter may be passed as
+ * argv[1] (substring match).
+ */
+#ifndef SH_MICROBENCH_H
+#define SH_MICROBENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef void (*bench_fn)(uint64_t iters);
+
+struct bench_case {
+    const char *name;
+    bench_fn    fn;
+};
+
+#define BENCH(name)                                                     \
+    static void bench_##name(uint64_t iters)
+
+#define BENCH_ENTRY(name) { #name, bench_##name }
+
+static inline void bench_keep(uint64_t v)
+{
+    __asm__ __volatile__("" : : "r"(v) : "memory");
+}
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline int bench_run_all(const struct bench_case *cases, size_t n,
+                                int argc, char **argv)
+{
+    const uint64_t min_time_ns = 200000000ull;   /* 0.2 s per case */
+    const char *filter = argc > 1 ? argv[1] : NULL;
+    size_t i;
+
+    printf("%-32s %14s %14s\n", "Benchmark", "Time(ns/op)", "Iterations");
+    printf("%.*s\n", 62, "----------------------------------------"
+                         "----------------------------------------");
+    for (i = 0; i < n; i++) {
+        uint64_t iters = 1, t;
+
+        if (filter && !strstr(cases[i].name, filter))
+            continue;
+        for (;;) {
+            uint64_t t0 = bench_now_ns();
+
+            cases[i].fn(iters);
+            t = bench_now_ns() - t0;
+            if (t >= min_time_ns || iters >= (1ull << 40))
+                break;
+            iters *= t ? (min_time_ns * 12 / 10 / t) + 1 : 10;
+        }
+        printf("%-32s %14.2f %14llu\n", cases[i].name,
+               (double)t / iters, (unsigned long long)iters);
+    }
+    return 0;
+}
+
+#endif /* SH_MICROBENCH_H */
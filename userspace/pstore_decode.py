@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""pstore_decode.py - rebuild the sys_health_monitor timeline after a crash.
+
+On panic the module prints its newest history records to the kernel log as
+"SHM1" lines, which a pstore backend such as ramoops saves with the rest of
+the log.  After reboot, mount pstore and point this script at the dmesg
+files (default: every /sys/fs/pstore/dmesg-*):
+
+  H <version> <metrics> <record_size> <poll_ms> <le|be> <total_records>
+  M <index> <name> <unit>
+  R <crc32> <hex of struct sh_record>
+
+The H and M lines come both before and after the R lines, so a dump whose
+start fell out of pstore's kmsg_bytes still decodes.
+
+Records whose CRC does not match (torn by the panic, or cut at a pstore
+part boundary) are dropped and counted.  Output is one row per sample,
+oldest first; a value in a warning state is marked "!", critical "!!".
+
+  mount -t pstore pstore /sys/fs/pstore
+  userspace/pstore_decode.py                 # table
+  userspace/pstore_decode.py --csv out.csv   # CSV with severities
+"""
+
+import argparse
+import csv
+import datetime
+import glob
+import re
+import struct
+import sys
+import zlib
+
+LINE_RE = re.compile(r"SHM1 ([HMR]) (.*)$")
+SEVERITY = ["info", "warning", "critical", "?"]
+MARK = ["", "!", "!!", "?"]
+
+
+def parse(paths):
+    header, metrics, records, bad = None, {}, {}, 0
+    for path in paths:
+        with open(path, errors="replace") as f:
+            for line in f:
+                m = LINE_RE.search(line.rstrip("\n"))
+                if not m:
+                    continue
+                kind, rest = m.group(1), m.group(2).split()
+                if kind == "H" and len(rest) >= 5:
+                    header = {"version": int(rest[0]),
+                              "count": int(rest[1]),
+                              "size": int(rest[2]),
+                              "poll_ms": int(rest[3]),
+                              "endian": "<" if rest[4] == "le" else ">"}
+                elif kind == "M" and len(rest) == 3:
+                    metrics[int(rest[0])] = (rest[1], rest[2])
+                elif kind == "R" and len(rest) == 2:
+                    try:
+                        crc, raw = int(rest[0], 16), bytes.fromhex(rest[1])
+                    except ValueError:
+                        bad += 1
+                        continue
+                    if zlib.crc32(raw) != crc:
+                        bad += 1
+                        continue
+                    records[raw] = None     # dedupe across pstore parts
+    return header, metrics, list(records), bad
+
+
+def decode(header, raws):
+    """struct sh_record: v1 has one value per metric and a severity word,
+    v2 (sys_health_uapi.h) a fixed value array, severity and flags."""
+    count = header["count"]
+    if header["version"] == 1:
+        nvals, tail = count, "I"
+    else:
+        nvals, tail = (header["size"] - 24) // 4, "II"
+    fmt = header["endian"] + "QQ" + "I" * nvals + tail
+    need = struct.calcsize(fmt)
+    out = {}
+    for raw in raws:
+        if len(raw) != header["size"] or len(raw) < need:
+            continue
+        fields = struct.unpack_from(fmt, raw)
+        seq, wall_ms, values, sev = (fields[0], fields[1],
+                                     fields[2:2 + count], fields[2 + nvals])
+        if header["version"] > 1 and fields[3 + nvals]:
+            continue                        # gap markers carry no sample
+        levels = [(sev >> (2 * i)) & 3 for i in range(count)]
+        out[seq] = (wall_ms, values, levels)
+    return sorted(out.items())
+
+
+def when(wall_ms):
+    ts = datetime.datetime.fromtimestamp(wall_ms / 1000.0,
+                                         datetime.timezone.utc)
+    return ts.strftime("%Y-%m-%d %H:%M:%S.%f")[:-3]
+
+
+def main():
+    ap = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    ap.add_argument("files", nargs="*",
+                    help="pstore dmesg files (default /sys/fs/pstore/dmesg-*)")
+    ap.add_argument("--csv", metavar="FILE",
+                    help="write CSV instead of a table ('-' for stdout)")
+    args = ap.parse_args()
+
+    paths = args.files or sorted(glob.glob("/sys/fs/pstore/dmesg-*"))
+    if not paths:
+        sys.exit("no pstore dmesg files found (is pstore mounted?)")
+    header, metrics, raws, bad = parse(paths)
+    if header is None:
+        sys.exit("no SHM1 header found; was pstore_samples=0 or no panic?")
+    if header["version"] not in (1, 2):
+        sys.exit(f"record version {header['version']} not supported")
+
+    names = [metrics.get(i, (f"m{i}", ""))[0] for i in range(header["count"])]
+    rows = decode(header, raws)
+    print(f"{len(rows)} records, {bad} dropped, poll_ms {header['poll_ms']}",
+          file=sys.stderr)
+
+    if args.csv:
+        f = sys.stdout if args.csv == "-" else open(args.csv, "w", newline="")
+        out = csv.writer(f)
+        out.writerow(["seq", "wall_ms", "time_utc"] + names +
+                     [n + "_severity" for n in names])
+        for seq, (wall_ms, values, levels) in rows:
+            out.writerow([seq, wall_ms, when(wall_ms)] + list(values) +
+                         [SEVERITY[l] for l in levels])
+        if f is not sys.stdout:
+            f.close()
+        return
+
+    width = [max(len(n), 10) for n in names]
+    print(f"{'seq':>8} {'time (UTC)':<23} " +
+          " ".join(f"{n:>{w}}" for n, w in zip(names, width)))
+    for seq, (wall_ms, values, levels) in rows:
+        cells = [f"{v}{MARK[l]}" for v, l in zip(values, levels)]
+        print(f"{seq:>8} {when(wall_ms):<23} " +
+              " ".join(f"{c:>{w}}" for c, w in zip(cells, width)))
+
+
+if __name__ == "__main__":
+    main()
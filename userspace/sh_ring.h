@@ -0,0 +1,158 @@
+/*
+ * sh_ring.h – consumer side of the /proc/sys_health_ring mmap ring.
+ *
+ * Header‑only, no dependencies beyond libc.  Maps the ring read‑only and
+ * follows it with a private cursor: sh_ring_read() copies out whatever the
+ * kernel has published since the last call, without a syscall, and counts
+ * records that were overwritten before they could be copied.
+ *
+ *     struct sh_ring r;
+ *     struct sh_record buf[256];
+ *     uint64_t lost = 0;
+ *
+ *     if (sh_ring_open(&r, SH_RING_PATH) == 0) {
+ *         for (;;) {
+ *             int n = sh_ring_read(&r, buf, 256, &lost);
+ *             ...                              // n records, oldest first
+ *             if (!n)
+ *                 usleep(10000);               // or spin on sh_ring_head()
+ *         }
+ *     }
+ *
+ * Any number of readers may map the ring; none of them affects the kernel
+ * or the others.  A new reader starts at the oldest record still held;
+ * sh_ring_seek_end() skips to new records only.
+ */
+#ifndef SH_RING_H
+#define SH_RING_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../sys_health_uapi.h"
+
+#define SH_RING_PATH "/proc/sys_health_ring"
+
+struct sh_ring {
+    void                        *base;
+    size_t                       len;
+    const struct sh_ring_page   *ctl;
+    const struct sh_record      *data;
+    uint64_t                     slots;
+    uint64_t                     cursor;    /* next sequence number to copy */
+};
+
+static inline uint64_t sh_ring_head(const struct sh_ring *r)
+{
+    return __atomic_load_n(&r->ctl->head, __ATOMIC_ACQUIRE);
+}
+
+/* Oldest sequence number that cannot be mid‑overwrite given @head. */
+static inline uint64_t sh_ring_oldest(const struct sh_ring *r, uint64_t head)
+{
+    return head >= r->slots ? head - r->slots + 1 : 0;
+}
+
+/* Map an already open ring; also used on a plain buffer by simulations. */
+static inline int sh_ring_attach(struct sh_ring *r, void *base, size_t len)
+{
+    const struct sh_ring_page *ctl = base;
+
+    if (len < sizeof(*ctl) || ctl->version != SH_RECORD_VERSION ||
+        ctl->record_size != sizeof(struct sh_record) || !ctl->nr_records ||
+        ctl->data_offset + ctl->data_size > len)
+        return -EPROTO;
+    r->base   = base;
+    r->len    = len;
+    r->ctl    = ctl;
+    r->data   = (const struct sh_record *)((const char *)base +
+                                           ctl->data_offset);
+    r->slots  = ctl->nr_records;
+    r->cursor = sh_ring_oldest(r, sh_ring_head(r));
+    return 0;
+}
+
+/* Returns 0 or a negative errno. */
+static inline int sh_ring_open(struct sh_ring *r, const char *path)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    struct sh_ring_page *ctl;
+    size_t len;
+    void *base;
+    int fd, ret;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -errno;
+    /* The control page says how large the whole mapping is. */
+    ctl = mmap(NULL, page, PROT_READ, MAP_SHARED, fd, 0);
+    if (ctl == MAP_FAILED) {
+        ret = -errno;
+        close(fd);
+        return ret;
+    }
+    len = ctl->data_offset + ctl->data_size;
+    munmap(ctl, page);
+    base = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    ret = base == MAP_FAILED ? -errno : 0;
+    close(fd);                      /* the mapping keeps the ring alive */
+    if (ret)
+        return ret;
+    ret = sh_ring_attach(r, base, len);
+    if (ret)
+        munmap(base, len);
+    return ret;
+}
+
+static inline void sh_ring_close(struct sh_ring *r)
+{
+    munmap(r->base, r->len);
+    r->base = NULL;
+}
+
+static inline void sh_ring_seek_end(struct sh_ring *r)
+{
+    r->cursor = sh_ring_head(r);
+}
+
+/*
+ * Copy up to @max records published since the last call into @out, oldest
+ * first, and return how many.  Records overwritten before they were copied
+ * are skipped and added to *@lost; the ones returned are whole and in
+ * sequence order.
+ */
+static inline int sh_ring_read(struct sh_ring *r, struct sh_record *out,
+                               unsigned int max, uint64_t *lost)
+{
+    uint64_t head = sh_ring_head(r), start, valid, n, i;
+
+    start = sh_ring_oldest(r, head);
+    if (start < r->cursor)
+        start = r->cursor;
+    n = head - start < max ? head - start : max;
+    for (i = 0; i < n; i++)
+        out[i] = r->data[(start + i) % r->slots];
+
+    /* Whatever the kernel overwrote while we copied is torn: drop it. */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    valid = sh_ring_oldest(r, __atomic_load_n(&r->ctl->head,
+                                              __ATOMIC_RELAXED));
+    if (valid > start) {
+        uint64_t drop = valid - start < n ? valid - start : n;
+
+        memmove(out, out + drop, (n - drop) * sizeof(*out));
+        n -= drop;
+        start += drop;
+        if (start < valid)          /* overrun past everything we copied */
+            start = valid;
+    }
+    *lost += start - r->cursor;
+    r->cursor = start + n;
+    return (int)n;
+}
+
+#endif /* SH_RING_H */